@@ -0,0 +1,179 @@
+#include "include/socket/tcp_client.hpp"
+#include "include/socket/tcp_server.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <unordered_map>
+
+#include <sys/epoll.h>
+
+// Offered load below and above capacity against the same slow service, with and without admission control.
+// Clients are open-loop: connections start on a fixed schedule whether or not earlier ones were answered, so
+// an overloaded server builds a queue instead of slowing the clients down.
+
+namespace net = OFCT::networking;
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr size_t MESSAGE_SIZE = 64;
+constexpr size_t WORKERS = 4;
+
+// One request per connection, ~1 ms spent waiting on a (simulated) backend: capacity is about WORKERS / 1 ms.
+struct slow_handler {
+	bool transceive(std::atomic_bool const &, net::tcp_transceiver<net::sockaddr_type_in, false> const &transceiver) {
+		uint8_t message[MESSAGE_SIZE];
+		if(!transceiver.recv(message, sizeof(message))) return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		message[0] = 'O';
+		return transceiver.send(message, sizeof(message));
+	}
+};
+
+struct run_result {
+	std::vector<double> latencies;
+	size_t rejected = 0;
+	size_t failed = 0;
+};
+
+static run_result offer(in_port_t port, double rate, double seconds) {
+	struct client {
+		clock_type::time_point started;
+		size_t received = 0;
+		uint8_t buffer[MESSAGE_SIZE];
+	};
+
+	run_result result;
+	int const epfd = ::epoll_create1(EPOLL_CLOEXEC);
+	std::unordered_map<int, client> clients;
+	size_t const total = static_cast<size_t>(rate * seconds);
+	auto const period = std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(1 / rate));
+	auto const begin = clock_type::now();
+	auto next_start = begin;
+	auto const deadline = begin + std::chrono::duration<double>(seconds + 10);
+	size_t started = 0;
+
+	auto finish = [&](int fd, bool rejected) {
+		if(rejected) ++result.rejected;
+		::close(fd);
+		clients.erase(fd);
+	};
+
+	epoll_event events[256];
+	while((started < total || !clients.empty()) && clock_type::now() < deadline) {
+		auto now = clock_type::now();
+		for(; started < total && next_start <= now; ++started, next_start += period) {
+			int const fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+			sockaddr_in addr{};
+			addr.sin_family = AF_INET;
+			addr.sin_port = htons(port);
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) && errno != EINPROGRESS) {
+				::close(fd);
+				++result.failed;
+				continue;
+			}
+			// Latency is measured from the scheduled start, so time spent behind the generator counts too.
+			clients[fd].started = next_start;
+			epoll_event event{EPOLLOUT, {.fd = fd}};
+			::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event);
+		}
+
+		int const timeout = started < total ? 1 : 10;
+		int const ready = ::epoll_wait(epfd, events, 256, timeout);
+		for(int i = 0; i < ready; ++i) {
+			int const fd = events[i].data.fd;
+			auto it = clients.find(fd);
+			if(it == clients.end()) continue;
+			client &c = it->second;
+
+			if(events[i].events & EPOLLOUT) {
+				int error = 0;
+				socklen_t len = sizeof(error);
+				::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+				uint8_t request[MESSAGE_SIZE]{};
+				if(error || ::send(fd, request, sizeof(request), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(request))) {
+					finish(fd, true);
+					continue;
+				}
+				epoll_event event{EPOLLIN, {.fd = fd}};
+				::epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &event);
+				continue;
+			}
+
+			ssize_t const received = ::recv(fd, c.buffer + c.received, sizeof(c.buffer) - c.received, 0);
+			if(received <= 0) {
+				// Reset, closed or a busy reply followed by close: turned away.
+				finish(fd, true);
+				continue;
+			}
+			c.received += received;
+			if(c.buffer[0] != 'O') {
+				finish(fd, true);
+				continue;
+			}
+			if(c.received == MESSAGE_SIZE) {
+				result.latencies.push_back(std::chrono::duration<double, std::milli>(clock_type::now() - c.started).count());
+				finish(fd, false);
+			}
+		}
+	}
+	result.failed += clients.size();
+	for(auto &[fd, c] : clients) ::close(fd);
+	::close(epfd);
+	return result;
+}
+
+static void report(char const *name, double rate, double seconds, run_result &result) {
+	std::sort(result.latencies.begin(), result.latencies.end());
+	size_t const served = result.latencies.size();
+	auto percentile = [&](size_t p) { return served ? result.latencies[std::min(served - 1, served * p / 1000)] : 0.0; };
+	::printf("%-10s offered %6.0f/s  served %6.0f/s  rejected %5zu  failed %4zu  p50 %8.2f ms  p99 %8.2f ms  p99.9 %8.2f ms\n", name, rate,
+	         served / seconds, result.rejected, result.failed, percentile(500), percentile(990), percentile(999));
+}
+
+using server_t = net::tcp_server<net::sockaddr_type_in, false, slow_handler>;
+
+int main(int argc, char **argv) {
+	double const seconds = argc > 1 ? std::strtod(argv[1], nullptr) : 2;
+
+	net::admission_limits unguarded_limits;
+	unguarded_limits.target_delay = std::chrono::microseconds(0);
+	unguarded_limits.workers = WORKERS;
+	// Lets the queue grow without bound, to show what admission control prevents.
+	unguarded_limits.max_queued = std::numeric_limits<size_t>::max();
+
+	net::admission_limits guarded_limits;
+	guarded_limits.max_connections = 32;
+	guarded_limits.target_delay = std::chrono::milliseconds(5);
+	guarded_limits.interval = std::chrono::milliseconds(50);
+	guarded_limits.on_reject = net::rejection_busy_reply;
+	guarded_limits.busy_reply = "BUSY\r\n";
+	guarded_limits.workers = WORKERS;
+
+	net::admission_control unguarded(unguarded_limits);
+	net::admission_control guarded(guarded_limits);
+	server_t unguarded_server(slow_handler{}, 9990, "127.0.0.1");
+	server_t guarded_server(slow_handler{}, 9991, "127.0.0.1");
+	std::atomic_bool flag_quit(false);
+	std::thread unguarded_thread([&]() { unguarded_server.loop(flag_quit, unguarded); });
+	std::thread guarded_thread([&]() { guarded_server.loop(flag_quit, guarded); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	for(double rate : {1500.0, 6000.0}) {
+		run_result unguarded_result = offer(9990, rate, seconds);
+		report("unguarded", rate, seconds, unguarded_result);
+		run_result guarded_result = offer(9991, rate, seconds);
+		report("guarded", rate, seconds, guarded_result);
+	}
+	::printf("guarded: %lu over limit, %lu over rate, %lu shed\n", guarded.rejected_limit_count(), guarded.rejected_rate_count(), guarded.shed_count());
+
+	flag_quit.store(true, std::memory_order_release);
+	for(in_port_t port : {9990, 9991}) {
+		net::tcp_client<net::sockaddr_type_in, false> waker(port, "127.0.0.1");
+		(void) waker.connect();
+	}
+	unguarded_thread.join();
+	guarded_thread.join();
+}
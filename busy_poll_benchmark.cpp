@@ -0,0 +1,131 @@
+#include "include/event/event_loop.hpp"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+
+// Wakeup latency (send timestamp to handler) and loop-thread CPU for event_loop at different spin budgets,
+// with messages arriving at a fixed gap over a loopback TCP connection.
+
+namespace net = OFCT::networking;
+
+using clock_type = std::chrono::steady_clock;
+
+struct timestamp_reader : net::event_handler {
+	int fd;
+	std::vector<double> latencies;
+
+	explicit timestamp_reader(int fd) : fd(fd) {}
+
+	void handle(uint32_t) override {
+		int64_t stamps[64];
+		ssize_t const received = ::recv(fd, stamps, sizeof(stamps), MSG_DONTWAIT);
+		if(received <= 0) return;
+		int64_t const now = clock_type::now().time_since_epoch().count();
+		for(ssize_t i = 0; i < received / static_cast<ssize_t>(sizeof(int64_t)); ++i) latencies.push_back((now - stamps[i]) / 1e3);
+	}
+};
+
+static double thread_cpu_seconds() {
+	timespec ts;
+	::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool connected_pair(int &client, int &server) {
+	int const listener = ::socket(AF_INET, SOCK_STREAM, 0);
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t len = sizeof(addr);
+	if(::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) || ::listen(listener, 1)
+	   || ::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len)) return false;
+	client = ::socket(AF_INET, SOCK_STREAM, 0);
+	if(::connect(client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))) return false;
+	server = ::accept(listener, nullptr, nullptr);
+	::close(listener);
+	int const one = 1;
+	::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return server != -1;
+}
+
+static void measure(char const *name, net::busy_poll_options const &options, std::chrono::microseconds gap, size_t messages) {
+	int client, server;
+	if(!connected_pair(client, server)) {
+		::printf("Failed to set up the connection.\n");
+		return;
+	}
+
+	net::event_loop loop;
+	loop.set_busy_poll(options);
+	timestamp_reader reader(server);
+	if(!loop.add(server, EPOLLIN, reader)) return;
+
+	std::atomic_bool flag_quit(false);
+	double cpu = 0;
+	std::thread thread([&]() {
+		double const begin = thread_cpu_seconds();
+		loop.run(flag_quit);
+		cpu = thread_cpu_seconds() - begin;
+	});
+
+	auto const begin = clock_type::now();
+	auto next = begin;
+	for(size_t i = 0; i < messages; ++i) {
+		next += gap;
+		std::this_thread::sleep_until(next);
+		int64_t const stamp = clock_type::now().time_since_epoch().count();
+		if(::send(client, &stamp, sizeof(stamp), 0) != sizeof(stamp)) break;
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	double const wall = std::chrono::duration<double>(clock_type::now() - begin).count();
+	flag_quit.store(true, std::memory_order_release);
+	// Wakes the loop if it is parked in epoll_wait.
+	(void) loop.post([]() {});
+	thread.join();
+
+	std::vector<double> &samples = reader.latencies;
+	std::sort(samples.begin(), samples.end());
+	net::busy_poll_stats const stats = loop.get_busy_poll_stats();
+	if(samples.empty()) return;
+	::printf("gap %6ld us  %-15s  p50 %7.2f us  p99 %7.2f us  cpu %5.1f%%  spin hits %6lu  sleeps %6lu\n", long(gap.count()), name,
+	         samples[samples.size() / 2], samples[samples.size() * 99 / 100], 100 * cpu / wall, stats.spin_hits, stats.sleeps);
+	::close(client);
+	::close(server);
+}
+
+int main(int argc, char **argv) {
+	size_t const messages = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+
+	struct configuration {
+		char const *name;
+		net::busy_poll_options options;
+	};
+	auto fixed = [](long us) {
+		net::busy_poll_options options;
+		options.min_spin = options.max_spin = std::chrono::microseconds(us);
+		return options;
+	};
+	auto adaptive = [](long us) {
+		net::busy_poll_options options;
+		options.max_spin = std::chrono::microseconds(us);
+		return options;
+	};
+
+	configuration const configurations[] = {
+	  {"sleep", net::busy_poll_options{}},
+	  {"spin 20us", fixed(20)},
+	  {"spin 200us", fixed(200)},
+	  {"spin 2000us", fixed(2000)},
+	  {"adaptive 500us", adaptive(500)},
+	  {"adaptive 5000us", adaptive(5000)},
+	};
+	for(long gap : {50, 1000}) {
+		for(configuration const &config : configurations) measure(config.name, config.options, std::chrono::microseconds(gap), messages);
+	}
+}
@@ -0,0 +1,108 @@
+#include "include/broadcast/fanout.hpp"
+#include "include/socket/tcp_client.hpp"
+#include "include/socket/tcp_listener.hpp"
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+// Fan-out throughput over loopback: ./fanout_benchmark [subscribers] [messages] [message size] [threads]
+
+namespace net = OFCT::networking;
+
+class subscribe_server
+: public net::tcp_listener<net::sockaddr_type_in, false> {
+public:
+	explicit subscribe_server(net::fanout &broadcast, in_port_t port, std::string_view ip_str)
+	  : net::tcp_listener<net::sockaddr_type_in, false>(port, ip_str), broadcast(broadcast) {}
+
+protected:
+	virtual bool transceive(std::atomic_bool const &, net::tcp_transceiver<net::sockaddr_type_in, false> const &transceiver) final {
+		return broadcast.subscribe(transceiver.native_handle());
+	}
+
+private:
+	net::fanout &broadcast;
+};
+
+int main(int argc, char **argv) {
+	constexpr in_port_t port = 9995;
+	size_t subscribers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+	size_t const messages = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+	size_t const message_size = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 256;
+	size_t const threads = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : std::max(1u, std::thread::hardware_concurrency());
+
+	// Both ends of every connection live in this process.
+	rlimit limit{};
+	::getrlimit(RLIMIT_NOFILE, &limit);
+	limit.rlim_cur = limit.rlim_max;
+	::setrlimit(RLIMIT_NOFILE, &limit);
+	if(subscribers * 2 + 64 > limit.rlim_cur) {
+		subscribers = (limit.rlim_cur - 64) / 2;
+		::printf("Limited to %zu subscribers by RLIMIT_NOFILE.\n", subscribers);
+	}
+
+	net::fanout broadcast(threads, net::slow_subscriber_drop, messages * message_size);
+	subscribe_server server(broadcast, port, "127.0.0.1");
+	std::atomic_bool flag_quit(false);
+	std::thread server_thread([&]() { server.loop(flag_quit); });
+
+	std::vector<std::unique_ptr<net::tcp_client<net::sockaddr_type_in, false>>> clients;
+	int const epollfd = ::epoll_create1(0);
+	while(clients.size() < subscribers) {
+		auto client = std::make_unique<net::tcp_client<net::sockaddr_type_in, false>>(port, "127.0.0.1");
+		if(!client->connect()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
+		}
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.fd = client->native_handle();
+		::epoll_ctl(epollfd, EPOLL_CTL_ADD, client->native_handle(), &event);
+		clients.push_back(std::move(client));
+		// Keep the accept queue from overflowing, which would stall connects on SYN retransmits.
+		if(clients.size() % 1000 == 0) {
+			while(broadcast.subscriber_count() < clients.size()) std::this_thread::yield();
+		}
+	}
+	while(broadcast.subscriber_count() < subscribers) std::this_thread::yield();
+
+	size_t const expected = subscribers * messages * message_size;
+	std::atomic_size_t received = 0;
+	std::thread reader([&]() {
+		static uint8_t buffer[64 * 1024];
+		epoll_event events[256];
+		auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+		while(received.load(std::memory_order_relaxed) < expected && std::chrono::steady_clock::now() < deadline) {
+			int const count = ::epoll_wait(epollfd, events, 256, 100);
+			for(int i = 0; i < count; ++i) {
+				ssize_t const n = ::recv(events[i].data.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+				if(n > 0) received.fetch_add(n, std::memory_order_relaxed);
+			}
+		}
+	});
+
+	std::vector<uint8_t> body(message_size, 'x');
+	auto const begin = std::chrono::steady_clock::now();
+	for(size_t i = 0; i < messages; ++i) {
+		if(!broadcast.publish(net::payload(body.data(), body.size()))) ::printf("Message %zu was rejected by a full I/O thread queue.\n", i);
+	}
+	reader.join();
+	double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	::printf("subscribers %zu, messages %zu x %zu bytes, I/O threads %zu\n", subscribers, messages, message_size, threads);
+	::printf("%.0f deliveries/s, %.1f MiB/s, %.3f s, received %zu / %zu bytes, dropped %lu, disconnected %lu\n",
+	         subscribers * messages / seconds, received.load() / seconds / (1024 * 1024), seconds,
+	         received.load(), expected, broadcast.dropped_count(), broadcast.disconnected_count());
+	::close(epollfd);
+	flag_quit.store(true, std::memory_order_release);
+	{
+		// Unblocks accept() so the loop sees flag_quit; it subscribes and is dropped on its close like any other.
+		net::tcp_client<net::sockaddr_type_in, false> waker(port, "127.0.0.1");
+		(void) waker.connect();
+	}
+	server_thread.join();
+}
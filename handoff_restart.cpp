@@ -0,0 +1,63 @@
+#include "include/socket/fd_handoff.hpp"
+#include "include/socket/tcp_listener.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+// Zero-downtime restart: start one instance, then start another; the second one takes over the listening
+// socket of the first, which exits, without the port ever being closed.
+//   ./handoff_restart & echo hi | nc -q1 127.0.0.1 9994; ./handoff_restart & echo hi | nc -q1 127.0.0.1 9994
+
+namespace net = OFCT::networking;
+
+constexpr std::string_view control_path = "/tmp/ofct_handoff_restart.sock";
+
+class echo_server
+: public net::tcp_listener<net::sockaddr_type_in, false> {
+public:
+	explicit echo_server(in_port_t port, in_addr_t ip)
+	  : net::tcp_listener<net::sockaddr_type_in, false>(port, ip) {}
+
+	explicit echo_server(int sockfd)
+	  : net::tcp_listener<net::sockaddr_type_in, false>(net::inherit_socket, sockfd) {}
+
+protected:
+	virtual bool transceive(std::atomic_bool const &, net::tcp_transceiver<net::sockaddr_type_in, false> const &transceiver) final {
+		char buffer[1024];
+		ssize_t const received = transceiver.recv_raw(buffer, sizeof(buffer));
+		if(received <= 0) return true;
+		std::string const reply = "[" + std::to_string(::getpid()) + "] " + std::string(buffer, received);
+		return transceiver.send(reply);
+	}
+};
+
+int main() {
+	std::unique_ptr<echo_server> server;
+	std::vector<int> fds;
+	if(net::fd_handoff(control_path).take(fds) && fds.size() == 1) {
+		::printf("[%d] Took over listening socket from predecessor.\n", ::getpid());
+		server = std::make_unique<echo_server>(fds[0]);
+	}
+	else {
+		::printf("[%d] No predecessor; binding a fresh socket.\n", ::getpid());
+		server = std::make_unique<echo_server>(9994, INADDR_LOOPBACK);
+	}
+
+	std::atomic_bool flag_quit(false);
+	std::thread server_thread([&server, &flag_quit]() { server->loop(flag_quit); });
+
+	// Serve until a successor takes the socket over, then leave it the accept queue.
+	while(!net::fd_handoff(control_path).offer({server->native_handle()})) {
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+	}
+	::printf("[%d] Handed listening socket to successor; exiting.\n", ::getpid());
+
+	// A waker connection would land in the shared accept queue, so stop the loop through wake() instead; it
+	// finishes the connection it is serving, and closing our copy of the socket leaves the successor's open.
+	flag_quit.store(true, std::memory_order_release);
+	server->wake();
+	server_thread.join();
+	return 0;
+}
@@ -0,0 +1,136 @@
+#include "include/http/http_handler.hpp"
+#include "include/socket/tcp_client.hpp"
+
+#include <netinet/tcp.h>
+#include <pthread.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+// Requests/sec for a small response over loopback: keep-alive with one request at a time, pipelined
+// windows, and a new connection per request. The server serves on one thread; its CPU time is read from
+// that thread's clock, so "per core" is requests per CPU-second spent in the server.
+
+namespace net = OFCT::networking;
+
+constexpr in_port_t PORT = 9983;
+constexpr std::string_view REQUEST = "GET /hello HTTP/1.1\r\nHost: localhost\r\nUser-Agent: http_benchmark\r\nAccept: */*\r\n\r\n";
+constexpr std::string_view CLOSE_REQUEST = "GET /hello HTTP/1.1\r\nHost: localhost\r\nUser-Agent: http_benchmark\r\nConnection: close\r\n\r\n";
+
+struct hello_service {
+	void operator()(net::http_request const &request, net::http_response &response) {
+		if(request.path != "/hello") {
+			response.set_status(404);
+			return;
+		}
+		response.add_header("Content-Type", "text/plain");
+		response.set_body("Hello, World!");
+	}
+};
+
+using server_t = net::tcp_server<net::sockaddr_type_in, false, net::http_handler<hello_service>>;
+
+static double cpu_seconds(clockid_t clock) {
+	timespec ts{};
+	::clock_gettime(clock, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static net::tcp_client<net::sockaddr_type_in, false> *connect() {
+	auto *client = new net::tcp_client<net::sockaddr_type_in, false>(PORT, "127.0.0.1");
+	if(!client->connect()) {
+		::fprintf(stderr, "connect failed\n");
+		std::exit(1);
+	}
+	int const one = 1;
+	::setsockopt(client->native_handle(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return client;
+}
+
+// Reads until `bytes` have arrived.
+static bool drain(net::tcp_client<net::sockaddr_type_in, false> const &client, size_t bytes) {
+	static char buffer[256 * 1024];
+	while(bytes) {
+		ssize_t const received = client.recv_raw(buffer, std::min(bytes, sizeof(buffer)));
+		if(received <= 0) return false;
+		bytes -= received;
+	}
+	return true;
+}
+
+// Every response to REQUEST is the same length (the Date header is fixed-width).
+static size_t response_size() {
+	std::unique_ptr<net::tcp_client<net::sockaddr_type_in, false>> client(connect());
+	if(!client->send(CLOSE_REQUEST.data(), CLOSE_REQUEST.size())) std::exit(1);
+	char buffer[1024];
+	size_t total = 0;
+	while(true) {
+		ssize_t const received = client->recv_raw(buffer, sizeof(buffer));
+		if(received <= 0) break;
+		total += received;
+	}
+	// The probe asked for close, so its response also carries "Connection: close\r\n".
+	return total - std::string_view("Connection: close\r\n").size();
+}
+
+static void report(char const *name, size_t requests, double wall, double cpu) {
+	::printf("%-24s %9.0f req/s  %9.0f req/s per server core  (%zu requests)\n", name, requests / wall, requests / cpu, requests);
+}
+
+int main(int argc, char **argv) {
+	size_t const requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+
+	server_t server(net::http_handler<hello_service>(hello_service{}), PORT, "127.0.0.1");
+	std::atomic_bool flag_quit(false);
+	std::thread server_thread([&]() { server.loop(flag_quit); });
+	clockid_t server_clock;
+	::pthread_getcpuclockid(server_thread.native_handle(), &server_clock);
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	size_t const size = response_size();
+	::printf("response: %zu bytes\n", size);
+
+	for(size_t depth : {1, 16, 64, 256}) {
+		std::unique_ptr<net::tcp_client<net::sockaddr_type_in, false>> client(connect());
+		std::string window;
+		for(size_t i = 0; i < depth; ++i) window.append(REQUEST);
+		size_t const rounds = requests / depth;
+		double const cpu_begin = cpu_seconds(server_clock);
+		auto const begin = std::chrono::steady_clock::now();
+		for(size_t r = 0; r < rounds; ++r) {
+			if(!client->send(window.data(), window.size()) || !drain(*client, size * depth)) {
+				::fprintf(stderr, "transfer failed\n");
+				return 1;
+			}
+		}
+		double const wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		double const cpu = cpu_seconds(server_clock) - cpu_begin;
+		char name[64];
+		::snprintf(name, sizeof(name), depth == 1 ? "keep-alive" : "pipelined x%zu", depth);
+		report(name, rounds * depth, wall, cpu);
+	}
+
+	{
+		size_t const count = requests / 20;
+		double const cpu_begin = cpu_seconds(server_clock);
+		auto const begin = std::chrono::steady_clock::now();
+		for(size_t i = 0; i < count; ++i) {
+			std::unique_ptr<net::tcp_client<net::sockaddr_type_in, false>> client(connect());
+			if(!client->send(CLOSE_REQUEST.data(), CLOSE_REQUEST.size()) || !drain(*client, size + std::string_view("Connection: close\r\n").size())) {
+				::fprintf(stderr, "transfer failed\n");
+				return 1;
+			}
+		}
+		double const wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		report("connection per request", count, wall, cpu_seconds(server_clock) - cpu_begin);
+	}
+
+	flag_quit.store(true, std::memory_order_release);
+	{
+		net::tcp_client<net::sockaddr_type_in, false> waker(PORT, "127.0.0.1");
+		(void) waker.connect();
+	}
+	server_thread.join();
+}
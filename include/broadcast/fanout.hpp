@@ -0,0 +1,248 @@
+#ifndef OFCT_NETWORK_broadcast_fanout_hpp
+#define OFCT_NETWORK_broadcast_fanout_hpp
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "payload.hpp"
+#include "../event/event_loop.hpp"
+
+namespace OFCT::networking {
+
+	enum class slow_subscriber_policy { NONE, DROP, DISCONNECT };
+
+	constexpr auto slow_subscriber_drop = slow_subscriber_policy::DROP;
+	constexpr auto slow_subscriber_disconnect = slow_subscriber_policy::DISCONNECT;
+
+	// Sends one payload to many connections. Subscribers are spread over I/O threads; publish() posts a
+	// single task per thread, which queues a reference to the payload on each of its subscribers and then
+	// flushes them with one sendmsg() per subscriber covering everything queued since the last flush.
+	// A subscriber whose backlog would exceed max_pending bytes loses the message or the connection.
+	class fanout {
+		static constexpr size_t MAX_IOV = 64;
+
+	public:
+		static constexpr size_t DEFAULT_MAX_PENDING = 1 << 20;
+
+		explicit fanout(size_t thread_count = 1, slow_subscriber_policy policy = slow_subscriber_drop,
+		                size_t max_pending = DEFAULT_MAX_PENDING) {
+			for(size_t i = 0; i < thread_count; ++i) {
+				shards.push_back(std::make_unique<shard>(policy, max_pending));
+			}
+			for(auto &each : shards) {
+				threads.emplace_back([this, target = each.get()]() { target->io.run(flag_quit); });
+			}
+		}
+
+		fanout(fanout const &) = delete;
+		fanout &operator=(fanout const &) = delete;
+
+		~fanout() {
+			flag_quit.store(true, std::memory_order_release);
+			for(auto &thread : threads) thread.join();
+		}
+
+		// The socket is duplicated, so the caller keeps (and eventually closes) its own descriptor.
+		[[nodiscard]] bool subscribe(int sockfd) {
+			int const fd = ::dup(sockfd);
+			if(fd == -1) return false;
+			shard *target = shards[next_shard.fetch_add(1, std::memory_order_relaxed) % shards.size()].get();
+			if(!target->io.post([target, fd]() { target->adopt(fd); })) {
+				::close(fd);
+				return false;
+			}
+			return true;
+		}
+
+		// Returns false if an I/O thread's queue was full and its subscribers missed the message.
+		[[nodiscard]] bool publish(payload const &message) {
+			if(message.empty()) return true;
+			bool result = true;
+			for(auto &each : shards) {
+				shard *target = each.get();
+				if(!target->io.post([target, message]() { target->enqueue(message); })) result = false;
+			}
+			return result;
+		}
+
+		[[nodiscard]] size_t subscriber_count() const {
+			size_t count = 0;
+			for(auto const &each : shards) count += each->count.load(std::memory_order_relaxed);
+			return count;
+		}
+
+		[[nodiscard]] uint64_t dropped_count() const {
+			uint64_t count = 0;
+			for(auto const &each : shards) count += each->dropped.load(std::memory_order_relaxed);
+			return count;
+		}
+
+		[[nodiscard]] uint64_t disconnected_count() const {
+			uint64_t count = 0;
+			for(auto const &each : shards) count += each->disconnected.load(std::memory_order_relaxed);
+			return count;
+		}
+
+	private:
+		class shard;
+
+		struct subscriber : event_handler {
+			shard *owner = nullptr;
+			int fd = -1;
+			size_t index = 0;
+			std::deque<payload> queue;
+			// Bytes of queue.front() already sent.
+			size_t offset = 0;
+			size_t pending = 0;
+			bool writable_armed = false;
+			bool closed = false;
+
+			void handle(uint32_t events) final { owner->on_event(*this, events); }
+		};
+
+		// Everything but the counters belongs to the shard's I/O thread.
+		class shard {
+		public:
+			explicit shard(slow_subscriber_policy policy, size_t max_pending) : policy(policy), max_pending(max_pending) {}
+
+			~shard() {
+				for(auto &sub : subscribers) ::close(sub->fd);
+			}
+
+			event_loop io;
+			std::atomic_size_t count = 0;
+			std::atomic_uint64_t dropped = 0;
+			std::atomic_uint64_t disconnected = 0;
+
+			void adopt(int fd) {
+				auto sub = std::make_unique<subscriber>();
+				sub->owner = this;
+				sub->fd = fd;
+				sub->index = subscribers.size();
+				// Subscribers are not read from; only hang-ups and, when backlogged, writability matter.
+				if(!io.add(fd, EPOLLRDHUP, *sub)) {
+					::close(fd);
+					return;
+				}
+				subscribers.push_back(std::move(sub));
+				count.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			void enqueue(payload const &message) {
+				for(size_t i = 0; i < subscribers.size();) {
+					subscriber &sub = *subscribers[i];
+					if(sub.pending + message.size() > max_pending) {
+						if(policy == slow_subscriber_disconnect) {
+							disconnected.fetch_add(1, std::memory_order_relaxed);
+							remove(sub);
+							continue;
+						}
+						dropped.fetch_add(1, std::memory_order_relaxed);
+						++i;
+						continue;
+					}
+					// A subscriber with a backlog is flushed by EPOLLOUT instead.
+					if(sub.queue.empty()) dirty.push_back(&sub);
+					sub.queue.push_back(message);
+					sub.pending += message.size();
+					++i;
+				}
+				// Posted behind any publishes already queued, so they all go out in the same sendmsg().
+				if(!flush_scheduled) {
+					flush_scheduled = true;
+					if(!io.post([this]() { flush_all(); })) flush_all();
+				}
+			}
+
+			void on_event(subscriber &sub, uint32_t events) {
+				if((events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) || ((events & EPOLLOUT) && !flush(sub))) remove(sub);
+			}
+
+		private:
+			slow_subscriber_policy policy;
+			size_t max_pending;
+			std::vector<std::unique_ptr<subscriber>> subscribers;
+			std::vector<subscriber*> dirty;
+			// Subscribers removed while dirty may still point at them.
+			std::vector<std::unique_ptr<subscriber>> graveyard;
+			bool flush_scheduled = false;
+
+			void flush_all() {
+				flush_scheduled = false;
+				for(subscriber *sub : dirty) {
+					if(!sub->closed && !flush(*sub)) remove(*sub);
+				}
+				dirty.clear();
+				graveyard.clear();
+			}
+
+			// Returns false when the connection is gone.
+			[[nodiscard]] bool flush(subscriber &sub) {
+				while(!sub.queue.empty()) {
+					iovec iov[MAX_IOV];
+					size_t iovlen = 0;
+					for(auto it = sub.queue.begin(); it != sub.queue.end() && iovlen < MAX_IOV; ++it, ++iovlen) {
+						size_t const skip = iovlen ? 0 : sub.offset;
+						iov[iovlen].iov_base = const_cast<uint8_t*>(it->data() + skip);
+						iov[iovlen].iov_len = it->size() - skip;
+					}
+					msghdr msg{};
+					msg.msg_iov = iov;
+					msg.msg_iovlen = iovlen;
+					ssize_t const sent = ::sendmsg(sub.fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+					if(sent == -1) {
+						if(errno == EAGAIN || errno == EWOULDBLOCK) break;
+						return false;
+					}
+					sub.pending -= sent;
+					size_t left = sent;
+					while(left) {
+						size_t const remaining = sub.queue.front().size() - sub.offset;
+						if(left < remaining) {
+							sub.offset += left;
+							break;
+						}
+						left -= remaining;
+						sub.offset = 0;
+						sub.queue.pop_front();
+					}
+				}
+
+				bool const backlogged = !sub.queue.empty();
+				if(backlogged != sub.writable_armed) {
+					sub.writable_armed = backlogged;
+					return io.modify(sub.fd, backlogged ? EPOLLRDHUP | EPOLLOUT : EPOLLRDHUP, sub);
+				}
+				return true;
+			}
+
+			// Closing the descriptor also removes it from the epoll set.
+			void remove(subscriber &sub) {
+				::close(sub.fd);
+				sub.closed = true;
+				size_t const index = sub.index;
+				std::unique_ptr<subscriber> owned = std::move(subscribers[index]);
+				if(index + 1 != subscribers.size()) {
+					subscribers[index] = std::move(subscribers.back());
+					subscribers[index]->index = index;
+				}
+				subscribers.pop_back();
+				count.fetch_sub(1, std::memory_order_relaxed);
+				if(!dirty.empty()) graveyard.push_back(std::move(owned));
+			}
+		};
+
+		std::vector<std::unique_ptr<shard>> shards;
+		std::vector<std::thread> threads;
+		std::atomic_size_t next_shard = 0;
+		std::atomic_bool flag_quit = false;
+	};
+}
+
+#endif
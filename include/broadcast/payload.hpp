@@ -0,0 +1,35 @@
+#ifndef OFCT_NETWORK_broadcast_payload_hpp
+#define OFCT_NETWORK_broadcast_payload_hpp
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace OFCT::networking {
+
+	// Immutable, reference-counted message body. Copies share the bytes, so one payload can be
+	// queued on any number of connections without duplicating it.
+	class payload {
+	public:
+		payload() = default;
+
+		explicit payload(void const *buf, size_t len)
+		  : bytes(std::make_shared<std::vector<uint8_t> const>(static_cast<uint8_t const*>(buf), static_cast<uint8_t const*>(buf) + len)) {}
+
+		explicit payload(std::string_view buf) : payload(buf.data(), buf.size()) {}
+
+		explicit payload(std::vector<uint8_t> &&buf)
+		  : bytes(std::make_shared<std::vector<uint8_t> const>(std::move(buf))) {}
+
+		[[nodiscard]] uint8_t const *data() const { return bytes ? bytes->data() : nullptr; }
+		[[nodiscard]] size_t size() const { return bytes ? bytes->size() : 0; }
+		[[nodiscard]] bool empty() const { return size() == 0; }
+
+	private:
+		std::shared_ptr<std::vector<uint8_t> const> bytes;
+	};
+}
+
+#endif
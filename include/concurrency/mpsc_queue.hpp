@@ -0,0 +1,88 @@
+#ifndef OFCT_NETWORK_concurrency_mpsc_queue_hpp
+#define OFCT_NETWORK_concurrency_mpsc_queue_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace OFCT::networking {
+
+	// Bounded lock-free multi-producer single-consumer queue (Vyukov's sequence-per-cell ring).
+	// try_push may be called from any thread, try_pop/empty only from the consumer.
+	template<typename T>
+	class mpsc_queue {
+		static constexpr size_t CACHE_LINE_SIZE = 64;
+
+		struct cell {
+			std::atomic_size_t sequence;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+	public:
+		// capacity is rounded up to a power of two.
+		explicit mpsc_queue(size_t capacity) : mask(round_up(capacity) - 1), cells(new cell[mask + 1]) {
+			for(size_t i = 0; i <= mask; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		mpsc_queue(mpsc_queue const &) = delete;
+		mpsc_queue &operator=(mpsc_queue const &) = delete;
+
+		~mpsc_queue() {
+			T value;
+			while(try_pop(value)) {}
+		}
+
+		// Returns false when the queue is full; value is left untouched in that case.
+		[[nodiscard]] bool try_push(T &&value) {
+			size_t pos = tail.load(std::memory_order_relaxed);
+			cell *target;
+			while(true) {
+				target = &cells[pos & mask];
+				size_t const sequence = target->sequence.load(std::memory_order_acquire);
+				auto const diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+				if(diff == 0) {
+					if(tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+				}
+				else if(diff < 0) return false;
+				else pos = tail.load(std::memory_order_relaxed);
+			}
+			::new(static_cast<void*>(target->storage)) T(std::move(value));
+			target->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		[[nodiscard]] bool try_pop(T &value) {
+			cell &target = cells[head & mask];
+			if(target.sequence.load(std::memory_order_acquire) != head + 1) return false;
+			T *stored = std::launder(reinterpret_cast<T*>(target.storage));
+			value = std::move(*stored);
+			stored->~T();
+			target.sequence.store(head + mask + 1, std::memory_order_release);
+			++head;
+			return true;
+		}
+
+		[[nodiscard]] bool empty() const {
+			return cells[head & mask].sequence.load(std::memory_order_acquire) != head + 1;
+		}
+
+		[[nodiscard]] size_t capacity() const { return mask + 1; }
+
+	private:
+		size_t const mask;
+		std::unique_ptr<cell[]> cells;
+		alignas(CACHE_LINE_SIZE) std::atomic_size_t tail = 0;
+		alignas(CACHE_LINE_SIZE) size_t head = 0;
+
+		static constexpr size_t round_up(size_t capacity) {
+			size_t result = 1;
+			while(result < capacity) result <<= 1;
+			return result;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef OFCT_NETWORK_event_event_loop_hpp
+#define OFCT_NETWORK_event_event_loop_hpp
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "../concurrency/mpsc_queue.hpp"
+#include "../debug/debug_mode.hpp"
+#include "../exceptions/socket_exceptions.hpp"
+
+namespace OFCT::networking {
+
+	class event_handler {
+	public:
+		virtual ~event_handler() = default;
+		virtual void handle(uint32_t events) = 0;
+	};
+
+	// Low-latency mode for event_loop: before blocking in epoll_wait, the loop polls without sleeping for a
+	// window that adapts to how soon work has been arriving. Arrivals closer together than max_spin are caught
+	// while still spinning, skipping the wakeup; when they are further apart the window shrinks to min_spin,
+	// since spinning would only burn CPU.
+	struct busy_poll_options {
+		std::chrono::microseconds min_spin{0};
+		std::chrono::microseconds max_spin{0};
+		// Applied to sockets registered through add(); 0 leaves them alone. Raising SO_BUSY_POLL above
+		// net.core.busy_read needs CAP_NET_ADMIN, and failures are ignored.
+		unsigned socket_busy_poll_us = 0;
+		bool prefer_busy_poll = false;
+		uint16_t busy_poll_budget = 0;
+	};
+
+	struct busy_poll_stats {
+		// Iterations whose work was found while spinning / after sleeping in epoll_wait.
+		uint64_t spin_hits = 0;
+		uint64_t sleeps = 0;
+		std::chrono::nanoseconds spin_window{0};
+	};
+
+	// One epoll instance driven by one thread. Other threads hand it work through post(); the eventfd is
+	// written only when the loop is parked in epoll_wait, so a busy loop takes no syscall per post.
+	class event_loop {
+		static constexpr int MAX_EVENTS = 256;
+
+	public:
+		using task = std::function<void()>;
+
+		static constexpr size_t DEFAULT_QUEUE_SIZE = 4096;
+
+		explicit event_loop(size_t queue_size = DEFAULT_QUEUE_SIZE)
+		  : tasks(queue_size), epollfd(::epoll_create1(EPOLL_CLOEXEC)), wakefd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+			epoll_event event{};
+			event.events = EPOLLIN;
+			event.data.ptr = nullptr;
+			if(epollfd == -1 || wakefd == -1 || ::epoll_ctl(epollfd, EPOLL_CTL_ADD, wakefd, &event) == -1) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to generate epoll instance: errno = %d\n", errno);
+				}
+				if(epollfd != -1) ::close(epollfd);
+				if(wakefd != -1) ::close(wakefd);
+				throw epoll_generation_failed_exception();
+			}
+		}
+
+		event_loop(event_loop const &) = delete;
+		event_loop &operator=(event_loop const &) = delete;
+
+		~event_loop() {
+			::close(wakefd);
+			::close(epollfd);
+		}
+
+		// Any thread. Returns false when the queue is full; the caller decides whether to retry or shed.
+		[[nodiscard]] bool post(task &&work) {
+			if(!tasks.try_push(std::move(work))) return false;
+			// Pairs with the fence in run_once(): either the loop sees the task before sleeping or we see it asleep.
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(sleeping.load(std::memory_order_relaxed) && sleeping.exchange(false, std::memory_order_relaxed)) {
+				uint64_t const one = 1;
+				[[maybe_unused]] ssize_t const written = ::write(wakefd, &one, sizeof(one));
+			}
+			return true;
+		}
+
+		// Loop thread only, before run().
+		void set_busy_poll(busy_poll_options const &options) {
+			busy_poll = options;
+			spin_window = options.min_spin;
+		}
+
+		[[nodiscard]] busy_poll_stats get_busy_poll_stats() const {
+			return busy_poll_stats{spin_hits, sleeps, spin_window};
+		}
+
+		// Loop thread only.
+		[[nodiscard]] bool add(int fd, uint32_t events, event_handler &handler) const {
+			if(busy_poll.socket_busy_poll_us) apply_socket_busy_poll(fd);
+			epoll_event event{};
+			event.events = events;
+			event.data.ptr = &handler;
+			return !::epoll_ctl(epollfd, EPOLL_CTL_ADD, fd, &event);
+		}
+
+		[[nodiscard]] bool modify(int fd, uint32_t events, event_handler &handler) const {
+			epoll_event event{};
+			event.events = events;
+			event.data.ptr = &handler;
+			return !::epoll_ctl(epollfd, EPOLL_CTL_MOD, fd, &event);
+		}
+
+		[[nodiscard]] bool remove(int fd) const {
+			return !::epoll_ctl(epollfd, EPOLL_CTL_DEL, fd, nullptr);
+		}
+
+		// Loop thread only. Runs after the current batch of I/O events, e.g. to free a handler that
+		// may still be referenced by an event later in the same batch.
+		void defer(task &&work) {
+			deferred.push_back(std::move(work));
+		}
+
+		// Runs posted tasks, then waits up to timeout_ms for I/O and dispatches it.
+		void run_once(int timeout_ms) {
+			drain();
+
+			epoll_event events[MAX_EVENTS];
+			int count = 0;
+			if(busy_poll.max_spin.count() == 0) count = wait(events, timeout_ms);
+			else {
+				auto const idle_since = clock::now();
+				bool const hit = spin(events, count, idle_since);
+				if(!hit) count = wait(events, timeout_ms);
+				if(hit) ++spin_hits;
+				else ++sleeps;
+				if(hit || count > 0 || !tasks.empty()) adapt(clock::now() - idle_since);
+			}
+
+			for(int i = 0; i < count; ++i) {
+				if(events[i].data.ptr == nullptr) {
+					uint64_t value;
+					[[maybe_unused]] ssize_t const drained = ::read(wakefd, &value, sizeof(value));
+				}
+				else static_cast<event_handler*>(events[i].data.ptr)->handle(events[i].events);
+			}
+			for(auto &work : deferred) work();
+			deferred.clear();
+		}
+
+		void run(std::atomic_bool const &flag_quit, int timeout_ms = 100) {
+			while(!flag_quit.load(std::memory_order_acquire)) run_once(timeout_ms);
+			drain();
+		}
+
+		// Runs the posted tasks only, without waiting for or dispatching I/O. Besides run_once(), this is how
+		// an owner releases what queued tasks still hold once the loop thread has stopped.
+		void drain() {
+			task work;
+			while(tasks.try_pop(work)) work();
+		}
+
+	private:
+		using clock = std::chrono::steady_clock;
+
+		mpsc_queue<task> tasks;
+		int epollfd;
+		int wakefd;
+		std::atomic_bool sleeping = false;
+		std::vector<task> deferred;
+
+		busy_poll_options busy_poll;
+		clock::duration spin_window{0};
+		// Smoothed idle time before work arrived, 1/8 weight per sample.
+		clock::duration idle_average{0};
+		uint64_t spin_hits = 0;
+		uint64_t sleeps = 0;
+
+		[[nodiscard]] int wait(epoll_event *events, int timeout_ms) {
+			sleeping.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int const timeout = tasks.empty() ? timeout_ms : 0;
+			int const count = ::epoll_wait(epollfd, events, MAX_EVENTS, timeout);
+			sleeping.store(false, std::memory_order_relaxed);
+			return count;
+		}
+
+		// Polls epoll and the task queue without sleeping until something shows up or the window closes.
+		[[nodiscard]] bool spin(epoll_event *events, int &count, clock::time_point begin) {
+			if(spin_window.count() <= 0) return false;
+			clock::time_point const deadline = begin + spin_window;
+			do {
+				if(!tasks.empty()) return true;
+				count = ::epoll_wait(epollfd, events, MAX_EVENTS, 0);
+				if(count > 0) return true;
+			} while(clock::now() < deadline);
+			count = 0;
+			return false;
+		}
+
+		// Spins for about twice the typical gap when that fits the budget, otherwise as little as allowed.
+		void adapt(clock::duration idle) {
+			idle_average += (idle - idle_average) / 8;
+			clock::duration const wanted = 2 * idle_average;
+			spin_window = wanted <= busy_poll.max_spin ? std::max<clock::duration>(wanted, busy_poll.min_spin) : clock::duration(busy_poll.min_spin);
+		}
+
+		void apply_socket_busy_poll(int fd) const {
+			int const usecs = static_cast<int>(busy_poll.socket_busy_poll_us);
+			::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs));
+#ifdef SO_PREFER_BUSY_POLL
+			int const prefer = busy_poll.prefer_busy_poll;
+			::setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer));
+#endif
+#ifdef SO_BUSY_POLL_BUDGET
+			if(busy_poll.busy_poll_budget) {
+				int const budget = busy_poll.busy_poll_budget;
+				::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget));
+			}
+#endif
+		}
+	};
+}
+
+#endif
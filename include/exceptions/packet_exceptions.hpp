@@ -0,0 +1,6 @@
+#ifndef SERVER_PACKET_EXCEPTIONS_HPP
+#define SERVER_PACKET_EXCEPTIONS_HPP
+
+#include "packet_ring_setup_failure_exception.hpp"
+
+#endif
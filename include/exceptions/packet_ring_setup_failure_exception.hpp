@@ -0,0 +1,19 @@
+#ifndef SERVER_PACKET_RING_SETUP_FAILURE_EXCEPTION_HPP
+#define SERVER_PACKET_RING_SETUP_FAILURE_EXCEPTION_HPP
+
+#include <exception>
+#include <string>
+#include <string_view>
+
+namespace OFCT::networking {
+	class packet_ring_setup_failure_exception : public std::exception {
+	public:
+		packet_ring_setup_failure_exception(std::string_view step, int error)
+		  : message("Failed to set up packet ring; step = " + std::string(step) + ", errno = " + std::to_string(error)) {}
+		[[nodiscard]] char const *what() const noexcept final { return message.c_str(); }
+	private:
+		std::string message;
+	};
+}
+
+#endif
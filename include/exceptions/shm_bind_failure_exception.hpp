@@ -0,0 +1,19 @@
+#ifndef SERVER_SHM_BIND_FAILURE_EXCEPTION_HPP
+#define SERVER_SHM_BIND_FAILURE_EXCEPTION_HPP
+
+#include <exception>
+#include <string>
+#include <string_view>
+
+namespace OFCT::networking {
+	class shm_bind_failure_exception : public std::exception {
+	public:
+		explicit shm_bind_failure_exception(std::string_view path)
+		  : message("Failed to bind shared-memory control socket; path = " + std::string(path)) {}
+		[[nodiscard]] char const *what() const noexcept final { return message.c_str(); }
+	private:
+		std::string message;
+	};
+}
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef SERVER_SHM_EXCEPTIONS_HPP
+#define SERVER_SHM_EXCEPTIONS_HPP
+
+#include "shm_bind_failure_exception.hpp"
+
+#endif
@@ -3,5 +3,6 @@
 
 #include "socket_generation_failed_exception.hpp"
 #include "socket_nonblocking_setup_failed_exception.hpp"
+#include "epoll_generation_failed_exception.hpp"
 
 #endif
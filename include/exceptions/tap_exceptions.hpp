@@ -0,0 +1,6 @@
+#ifndef SERVER_TAP_EXCEPTIONS_HPP
+#define SERVER_TAP_EXCEPTIONS_HPP
+
+#include "tap_file_failure_exception.hpp"
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef SERVER_TAP_FILE_FAILURE_EXCEPTION_HPP
+#define SERVER_TAP_FILE_FAILURE_EXCEPTION_HPP
+
+#include <exception>
+#include <string>
+#include <string_view>
+
+namespace OFCT::networking {
+	class tap_file_failure_exception : public std::exception {
+	public:
+		tap_file_failure_exception(std::string_view path, int error)
+		  : message("Failed to open traffic tap file; path = " + std::string(path) + ", errno = " + std::to_string(error)) {}
+		[[nodiscard]] char const *what() const noexcept final { return message.c_str(); }
+	private:
+		std::string message;
+	};
+}
+
+#endif
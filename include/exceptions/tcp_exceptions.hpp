@@ -8,5 +8,6 @@
 #include "tcp_recv_failure_exception.hpp"
 #include "tcp_accept_failure_exception.hpp"
 #include "tcp_transceive_failure_exception.hpp"
+#include "tcp_inherited_socket_invalid_exception.hpp"
 
 #endif
@@ -0,0 +1,18 @@
+#ifndef SERVER_TCP_INHERITED_SOCKET_INVALID_EXCEPTION_HPP
+#define SERVER_TCP_INHERITED_SOCKET_INVALID_EXCEPTION_HPP
+
+#include <exception>
+#include <string>
+
+namespace OFCT::networking {
+	class tcp_inherited_socket_invalid_exception : public std::exception {
+	public:
+		explicit tcp_inherited_socket_invalid_exception(int sockfd)
+		  : message("Inherited socket is not a listening TCP socket; sockfd = " + std::to_string(sockfd)) {}
+		[[nodiscard]] char const *what() const noexcept final { return message.c_str(); }
+	private:
+		std::string message;
+	};
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef SERVER_TLS_CERTIFICATE_LOAD_FAILURE_EXCEPTION_HPP
+#define SERVER_TLS_CERTIFICATE_LOAD_FAILURE_EXCEPTION_HPP
+
+#include <exception>
+#include <string>
+#include <string_view>
+
+namespace OFCT::networking {
+	class tls_certificate_load_failure_exception : public std::exception {
+	public:
+		explicit tls_certificate_load_failure_exception(std::string_view path)
+		  : message("Failed to load certificate or key; path = " + std::string(path)) {}
+		[[nodiscard]] char const *what() const noexcept final { return message.c_str(); }
+	private:
+		std::string message;
+	};
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef SERVER_TLS_CONTEXT_GENERATION_FAILED_EXCEPTION_HPP
+#define SERVER_TLS_CONTEXT_GENERATION_FAILED_EXCEPTION_HPP
+
+#include <exception>
+
+namespace OFCT::networking {
+	class tls_context_generation_failed_exception : public std::exception {
+	public:
+		[[nodiscard]] char const *what() const noexcept final {
+			return "Failed to generate TLS context.";
+		}
+	};
+}
+
+#endif
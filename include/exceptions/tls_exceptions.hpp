@@ -0,0 +1,7 @@
+#ifndef SERVER_TLS_EXCEPTIONS_HPP
+#define SERVER_TLS_EXCEPTIONS_HPP
+
+#include "tls_context_generation_failed_exception.hpp"
+#include "tls_certificate_load_failure_exception.hpp"
+
+#endif
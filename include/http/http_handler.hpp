@@ -0,0 +1,228 @@
+#ifndef OFCT_NETWORK_http_http_handler_hpp
+#define OFCT_NETWORK_http_http_handler_hpp
+
+#include <netinet/tcp.h>
+#include <sys/uio.h>
+
+#include <charconv>
+#include <concepts>
+#include <cstring>
+#include <ctime>
+#include <string_view>
+#include <vector>
+
+#include "http_request.hpp"
+#include "http_response.hpp"
+#include "../socket/tcp_server.hpp"
+
+namespace OFCT::networking {
+
+	template<typename service_t>
+	concept http_service = requires(service_t &service, http_request const &request, http_response &response) {
+		service(request, response);
+	};
+
+	namespace http_detail {
+		// Responses of one recv batch, gathered for a single vectored send. Status lines, headers and copied
+		// bodies go into one arena; borrowed bodies are referenced where they are.
+		class response_batch {
+		public:
+			void append_copy(std::string_view bytes) {
+				if(!segments.empty() && !segments.back().data && segments.back().offset + segments.back().size == arena.size()) segments.back().size += bytes.size();
+				else segments.push_back(segment{nullptr, arena.size(), bytes.size()});
+				arena.insert(arena.end(), bytes.begin(), bytes.end());
+			}
+
+			void append_borrowed(std::string_view bytes) {
+				if(!bytes.empty()) segments.push_back(segment{bytes.data(), 0, bytes.size()});
+			}
+
+			template<typename number_t>
+			void append_number(number_t value) {
+				char digits[24];
+				auto const end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+				append_copy(std::string_view(digits, end - digits));
+			}
+
+			[[nodiscard]] bool empty() const { return segments.empty(); }
+
+			template<sockaddr_type type, bool nonblocking>
+			[[nodiscard]] bool flush(tcp_transceiver<type, nonblocking> const &transceiver) {
+				// Pointers into the arena are only taken now that it has stopped growing.
+				iovecs.clear();
+				for(segment const &s : segments) {
+					iovecs.push_back(iovec{const_cast<char*>(s.data ? s.data : arena.data() + s.offset), s.size});
+				}
+				bool const sent = transceiver.sendv(iovecs.data(), static_cast<int>(iovecs.size()));
+				segments.clear();
+				arena.clear();
+				return sent;
+			}
+
+		private:
+			struct segment {
+				// nullptr: at offset in the arena.
+				char const *data;
+				size_t offset;
+				size_t size;
+			};
+
+			std::vector<char> arena;
+			std::vector<segment> segments;
+			std::vector<iovec> iovecs;
+		};
+
+		// IMF-fixdate, regenerated at most once a second.
+		class date_cache {
+		public:
+			[[nodiscard]] std::string_view get() {
+				time_t const now = ::time(nullptr);
+				if(now != last) {
+					tm utc{};
+					::gmtime_r(&now, &utc);
+					length = ::strftime(text, sizeof(text), "%a, %d %b %Y %H:%M:%S GMT", &utc);
+					last = now;
+				}
+				return std::string_view(text, length);
+			}
+
+		private:
+			time_t last = -1;
+			char text[32]{};
+			size_t length = 0;
+		};
+	}
+
+	// HTTP/1.1 server protocol as a tcp_server handler. Requests are parsed in place in the receive buffer,
+	// connections are kept alive per HTTP/1.1 (or 1.0 with Connection: keep-alive) and every request that
+	// arrived in one recv is served before answering, so pipelined requests get all their responses back in a
+	// single vectored send. Steady state on a connection does not allocate: the buffers are reused and only
+	// grow.
+	template<typename service_t>
+	requires http_service<service_t>
+	class http_handler {
+		static constexpr size_t READ_BUFFER_SIZE = 16 * 1024;
+		// Buffered on top of the head and body limits per complete chunk of a chunked body: its size line and
+		// CRLFs, with room for a short extension.
+		static constexpr size_t CHUNK_FRAMING_ALLOWANCE = 32;
+
+	public:
+		explicit http_handler(service_t service, http_limits limits = {}) : service(std::move(service)), limits(limits), parser(limits) {}
+
+		template<sockaddr_type type, bool nonblocking>
+		bool transceive(std::atomic_bool const &flag_quit, tcp_transceiver<type, nonblocking> const &transceiver) {
+			// Responses go out a whole batch at a time, so Nagle could only hold back the tail of one behind an ACK.
+			int const one = 1;
+			::setsockopt(transceiver.native_handle(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+			std::vector<char> buffer(READ_BUFFER_SIZE);
+			http_detail::response_batch batch;
+			http_request request;
+			http_response response;
+			size_t filled = 0;
+			bool continue_sent = false;
+			while(!flag_quit.load(std::memory_order_acquire)) {
+				if(filled == buffer.size()) buffer.resize(buffer.size() * 2);
+				ssize_t const received = transceiver.recv_raw(buffer.data() + filled, buffer.size() - filled);
+				if(received == 0) return true;
+				if(received < 0) {
+					if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+					return true;
+				}
+				filled += received;
+
+				size_t offset = 0;
+				bool close = false;
+				while(offset < filled && !close) {
+					http_parse_status const status = parser.parse(std::span(buffer).subspan(offset, filled - offset), request);
+					if(status == parse_incomplete) {
+						if(request.head_size && request.expects_continue && !continue_sent) {
+							batch.append_copy("HTTP/1.1 100 Continue\r\n\r\n");
+							continue_sent = true;
+						}
+						// Bounds what a request can make us buffer, e.g. a chunk header that never ends. Chunk framing
+						// gets its own allowance, so a body sent as many small chunks is not cut off at the body limit.
+						if(filled - offset > limits.max_head_size + limits.max_body_size + request.chunk_scan.chunks * CHUNK_FRAMING_ALLOWANCE) {
+							write_error(batch, 413);
+							close = true;
+							break;
+						}
+						// Makes room for a declared body in one step instead of doubling towards it.
+						if(offset == 0 && request.expected_size > buffer.size()) buffer.resize(request.expected_size);
+						break;
+					}
+					if(status != parse_complete) {
+						write_error(batch, http_parse_status_to_status_code(status));
+						close = true;
+						break;
+					}
+					continue_sent = false;
+
+					response.reset();
+					service(request, response);
+					close = !request.keep_alive || !response.is_keep_alive();
+					write(batch, request, response, close);
+					offset += request.size;
+				}
+
+				// Flushed before the buffer is compacted: a borrowed body may point into the request.
+				if(!batch.empty() && !batch.flush(transceiver)) return true;
+				if(close) return true;
+				::memmove(buffer.data(), buffer.data() + offset, filled - offset);
+				filled -= offset;
+			}
+			return true;
+		}
+
+		[[nodiscard]] service_t &get_service() { return service; }
+
+	private:
+		service_t service;
+		http_limits limits;
+		http_parser parser;
+		http_detail::date_cache date;
+
+		void write_head(http_detail::response_batch &batch, unsigned code, std::string_view reason) {
+			batch.append_copy("HTTP/1.1 ");
+			batch.append_number(code);
+			batch.append_copy(" ");
+			batch.append_copy(reason);
+			batch.append_copy("\r\nDate: ");
+			batch.append_copy(date.get());
+			batch.append_copy("\r\n");
+		}
+
+		void write(http_detail::response_batch &batch, http_request const &request, http_response const &response, bool close) {
+			unsigned const code = response.get_status_code();
+			write_head(batch, code, response.get_reason_phrase());
+			for(http_header const &header : response.get_headers()) {
+				batch.append_copy(header.name);
+				batch.append_copy(": ");
+				batch.append_copy(header.value);
+				batch.append_copy("\r\n");
+			}
+			// 1xx, 204 and 304 responses carry neither a body nor its length.
+			bool const bodiless = code < 200 || code == 204 || code == 304;
+			std::string_view const body = response.get_body();
+			if(!bodiless) {
+				batch.append_copy("Content-Length: ");
+				batch.append_number(body.size());
+				batch.append_copy("\r\n");
+			}
+			if(close) batch.append_copy("Connection: close\r\n");
+			else if(request.version_minor == 0) batch.append_copy("Connection: keep-alive\r\n");
+			batch.append_copy("\r\n");
+
+			if(bodiless || request.method == method_head) return;
+			if(response.is_body_borrowed()) batch.append_borrowed(body);
+			else batch.append_copy(body);
+		}
+
+		void write_error(http_detail::response_batch &batch, unsigned code) {
+			write_head(batch, code, http_reason_phrase(code));
+			batch.append_copy("Content-Length: 0\r\nConnection: close\r\n\r\n");
+		}
+	};
+}
+
+#endif
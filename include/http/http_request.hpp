@@ -0,0 +1,359 @@
+#ifndef OFCT_NETWORK_http_http_request_hpp
+#define OFCT_NETWORK_http_http_request_hpp
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+namespace OFCT::networking {
+
+	enum class http_method { NONE, GET, HEAD, POST, PUT, DELETE, CONNECT, OPTIONS, TRACE, PATCH };
+
+	constexpr auto method_get = http_method::GET;
+	constexpr auto method_head = http_method::HEAD;
+	constexpr auto method_post = http_method::POST;
+	constexpr auto method_put = http_method::PUT;
+	constexpr auto method_delete = http_method::DELETE;
+	constexpr auto method_connect = http_method::CONNECT;
+	constexpr auto method_options = http_method::OPTIONS;
+	constexpr auto method_trace = http_method::TRACE;
+	constexpr auto method_patch = http_method::PATCH;
+
+	// NONE for extension methods; the request keeps the name either way.
+	constexpr http_method string_to_http_method(std::string_view name) {
+		if(name == "GET") return method_get;
+		if(name == "HEAD") return method_head;
+		if(name == "POST") return method_post;
+		if(name == "PUT") return method_put;
+		if(name == "DELETE") return method_delete;
+		if(name == "CONNECT") return method_connect;
+		if(name == "OPTIONS") return method_options;
+		if(name == "TRACE") return method_trace;
+		if(name == "PATCH") return method_patch;
+		return http_method::NONE;
+	}
+
+	enum class http_parse_status { NONE, COMPLETE, INCOMPLETE, INVALID, HEAD_TOO_LARGE, BODY_TOO_LARGE, UNSUPPORTED_ENCODING, UNSUPPORTED_VERSION };
+
+	constexpr auto parse_complete = http_parse_status::COMPLETE;
+	constexpr auto parse_incomplete = http_parse_status::INCOMPLETE;
+	constexpr auto parse_invalid = http_parse_status::INVALID;
+	constexpr auto parse_head_too_large = http_parse_status::HEAD_TOO_LARGE;
+	constexpr auto parse_body_too_large = http_parse_status::BODY_TOO_LARGE;
+	constexpr auto parse_unsupported_encoding = http_parse_status::UNSUPPORTED_ENCODING;
+	constexpr auto parse_unsupported_version = http_parse_status::UNSUPPORTED_VERSION;
+
+	// Status code to answer a request that failed to parse with; 0 for the non-error results.
+	constexpr unsigned http_parse_status_to_status_code(http_parse_status status) {
+		switch(status) {
+		case parse_invalid: return 400;
+		case parse_head_too_large: return 431;
+		case parse_body_too_large: return 413;
+		case parse_unsupported_encoding: return 501;
+		case parse_unsupported_version: return 505;
+		default: return 0;
+		}
+	}
+
+	struct http_limits {
+		// Request line and headers together.
+		size_t max_head_size = 64 * 1024;
+		size_t max_body_size = 16 * 1024 * 1024;
+	};
+
+	struct http_header {
+		std::string_view name;
+		std::string_view value;
+	};
+
+	namespace http_detail {
+		constexpr char to_lower(char c) {
+			return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+		}
+
+		constexpr bool iequals(std::string_view a, std::string_view b) {
+			if(a.size() != b.size()) return false;
+			for(size_t i = 0; i < a.size(); ++i) {
+				if(to_lower(a[i]) != to_lower(b[i])) return false;
+			}
+			return true;
+		}
+
+		constexpr std::string_view trim(std::string_view s) {
+			while(!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+			while(!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+			return s;
+		}
+
+		// Whether a comma-separated header value such as Connection lists token.
+		constexpr bool has_token(std::string_view list, std::string_view token) {
+			while(!list.empty()) {
+				size_t const comma = list.find(',');
+				if(iequals(trim(list.substr(0, comma)), token)) return true;
+				if(comma == std::string_view::npos) break;
+				list.remove_prefix(comma + 1);
+			}
+			return false;
+		}
+
+		constexpr bool is_token_char(char c) {
+			return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c && std::string_view("!#$%&'*+-.^_`|~").find(c) != std::string_view::npos);
+		}
+
+		constexpr bool is_token(std::string_view s) {
+			if(s.empty()) return false;
+			for(char c : s) {
+				if(!is_token_char(c)) return false;
+			}
+			return true;
+		}
+
+		// For a line as returned by next_line(), whose own CR is already gone: a CR left anywhere is a bare one,
+		// which RFC 9112 section 2.2 makes the whole element invalid.
+		constexpr bool has_bare_cr(std::string_view line) {
+			return line.find('\r') != std::string_view::npos;
+		}
+	}
+
+	// How far parse() got through a chunked body that has not fully arrived yet. Offsets are from the start
+	// of the request.
+	struct http_chunk_scan {
+		// Start of the next chunk-size line, or of the next trailer line once trailers is set.
+		size_t position = 0;
+		size_t body_size = 0;
+		// Complete chunks so far, not counting the last, empty one.
+		size_t chunks = 0;
+		bool trailers = false;
+	};
+
+	// A request parsed in place: every view points into the receive buffer and is valid until the handler
+	// reuses it, i.e. for the duration of the service call.
+	struct http_request {
+		static constexpr size_t MAX_HEADERS = 64;
+
+		http_method method = http_method::NONE;
+		std::string_view method_name;
+		// As sent, and split at '?'; not percent-decoded.
+		std::string_view target;
+		std::string_view path;
+		std::string_view query;
+		// 0 or 1 (HTTP/1.x).
+		int version_minor = 1;
+		std::array<http_header, MAX_HEADERS> headers;
+		size_t header_count = 0;
+		// De-chunked if the request used chunked transfer coding.
+		std::string_view body;
+		bool keep_alive = true;
+		bool expects_continue = false;
+		// Request line and headers; set once they are complete, even while the body is still incomplete.
+		size_t head_size = 0;
+		// Whole message, head and body; valid once parsing returned parse_complete.
+		size_t size = 0;
+		// Declared body size while the body is still incomplete, so the receive buffer can be grown to fit.
+		size_t expected_size = 0;
+		// Kept across parse() calls while a chunked body is incomplete; cleared once parsing returns anything else.
+		http_chunk_scan chunk_scan;
+
+		[[nodiscard]] std::span<http_header const> get_headers() const { return std::span(headers.data(), header_count); }
+
+		// First header of that name (case-insensitive); empty if there is none.
+		[[nodiscard]] std::string_view header(std::string_view name) const {
+			for(size_t i = 0; i < header_count; ++i) {
+				if(http_detail::iequals(headers[i].name, name)) return headers[i].value;
+			}
+			return {};
+		}
+
+		[[nodiscard]] bool has_header(std::string_view name) const {
+			for(size_t i = 0; i < header_count; ++i) {
+				if(http_detail::iequals(headers[i].name, name)) return true;
+			}
+			return false;
+		}
+	};
+
+	// Parses one HTTP/1.x request from the front of a receive buffer without copying or allocating. Header
+	// lines may end in CRLF or a bare LF; a CR anywhere else in a line is rejected. A chunked body is compacted in place once all of it has arrived,
+	// which is why the buffer is mutable. While a request is incomplete, pass the same http_request again
+	// with the buffer grown at its end: a chunked body is scanned only from where the last call stopped.
+	class http_parser {
+	public:
+		explicit http_parser(http_limits limits = {}) : limits(limits) {}
+
+		[[nodiscard]] http_parse_status parse(std::span<char> buffer, http_request &request) const {
+			request.header_count = 0;
+			request.head_size = 0;
+			request.size = 0;
+			request.expected_size = 0;
+			request.body = {};
+			request.expects_continue = false;
+
+			std::string_view const data(buffer.data(), buffer.size());
+			size_t position = 0;
+			std::string_view line;
+
+			// Empty lines ahead of a request line are ignored (a client may send a CRLF after a POST body).
+			do {
+				if(!next_line(data, position, line)) return head_incomplete(position);
+			} while(line.empty());
+
+			if(http_detail::has_bare_cr(line)) return parse_invalid;
+			if(http_parse_status const status = parse_request_line(line, request); status != parse_complete) return status;
+
+			bool chunked = false;
+			bool has_length = false;
+			size_t content_length = 0;
+			while(true) {
+				if(!next_line(data, position, line)) return head_incomplete(position);
+				if(line.empty()) break;
+				// Obsolete line folding is rejected rather than unfolded.
+				if(line.front() == ' ' || line.front() == '\t' || http_detail::has_bare_cr(line)) return parse_invalid;
+				size_t const colon = line.find(':');
+				if(colon == std::string_view::npos || !http_detail::is_token(line.substr(0, colon))) return parse_invalid;
+				if(request.header_count == http_request::MAX_HEADERS) return parse_head_too_large;
+				http_header &header = request.headers[request.header_count++];
+				header.name = line.substr(0, colon);
+				header.value = http_detail::trim(line.substr(colon + 1));
+
+				if(http_detail::iequals(header.name, "content-length")) {
+					size_t length = 0;
+					auto const [end, error] = std::from_chars(header.value.data(), header.value.data() + header.value.size(), length);
+					if(error != std::errc() || end != header.value.data() + header.value.size() || header.value.empty()) return parse_invalid;
+					if(has_length && length != content_length) return parse_invalid;
+					has_length = true;
+					content_length = length;
+				}
+				else if(http_detail::iequals(header.name, "transfer-encoding")) {
+					if(!http_detail::iequals(header.value, "chunked")) return parse_unsupported_encoding;
+					chunked = true;
+				}
+				else if(http_detail::iequals(header.name, "expect")) {
+					request.expects_continue = http_detail::iequals(header.value, "100-continue");
+				}
+			}
+			if(position > limits.max_head_size) return parse_head_too_large;
+			// Both framings at once is the classic request smuggling vector.
+			if(chunked && has_length) return parse_invalid;
+			request.head_size = position;
+
+			std::string_view const connection = request.header("connection");
+			request.keep_alive = request.version_minor >= 1 ? !http_detail::has_token(connection, "close") : http_detail::has_token(connection, "keep-alive");
+
+			if(chunked) return parse_chunked(buffer, position, request);
+
+			if(content_length > limits.max_body_size) return parse_body_too_large;
+			if(data.size() - position < content_length) {
+				request.expected_size = position + content_length;
+				return parse_incomplete;
+			}
+			request.body = data.substr(position, content_length);
+			request.size = position + content_length;
+			return parse_complete;
+		}
+
+	private:
+		http_limits limits;
+
+		[[nodiscard]] http_parse_status head_incomplete(size_t position) const {
+			return position > limits.max_head_size ? parse_head_too_large : parse_incomplete;
+		}
+
+		// Without its line ending; false if the buffer ends before one.
+		[[nodiscard]] static bool next_line(std::string_view data, size_t &position, std::string_view &line) {
+			size_t const end = data.find('\n', position);
+			if(end == std::string_view::npos) {
+				position = data.size();
+				return false;
+			}
+			line = data.substr(position, end - position);
+			if(!line.empty() && line.back() == '\r') line.remove_suffix(1);
+			position = end + 1;
+			return true;
+		}
+
+		[[nodiscard]] static http_parse_status parse_request_line(std::string_view line, http_request &request) {
+			size_t const first = line.find(' ');
+			size_t const last = line.rfind(' ');
+			if(first == std::string_view::npos || first == last) return parse_invalid;
+			request.method_name = line.substr(0, first);
+			request.target = line.substr(first + 1, last - first - 1);
+			std::string_view const version = line.substr(last + 1);
+			if(!http_detail::is_token(request.method_name) || request.target.empty() || request.target.find(' ') != std::string_view::npos) return parse_invalid;
+			if(version.size() != 8 || version.substr(0, 5) != "HTTP/" || version[6] != '.' || version[5] < '0' || version[5] > '9' || version[7] < '0' || version[7] > '9') return parse_invalid;
+			if(version[5] != '1') return parse_unsupported_version;
+
+			request.method = string_to_http_method(request.method_name);
+			request.version_minor = version[7] - '0';
+			size_t const question = request.target.find('?');
+			request.path = request.target.substr(0, question);
+			request.query = question == std::string_view::npos ? std::string_view() : request.target.substr(question + 1);
+			return parse_complete;
+		}
+
+		[[nodiscard]] http_parse_status parse_chunked(std::span<char> buffer, size_t body_begin, http_request &request) const {
+			http_parse_status const status = scan_chunked(buffer, body_begin, request);
+			if(status != parse_incomplete) request.chunk_scan = {};
+			return status;
+		}
+
+		// Checks that the whole chunked body is there before touching the buffer, then moves the chunk data
+		// together so the body is one contiguous view. Progress is saved in request.chunk_scan after every
+		// complete chunk or trailer line, so a body arriving over many receives is scanned once, not per receive.
+		[[nodiscard]] http_parse_status scan_chunked(std::span<char> buffer, size_t body_begin, http_request &request) const {
+			std::string_view const data(buffer.data(), buffer.size());
+			http_chunk_scan &scan = request.chunk_scan;
+			if(scan.position < body_begin || scan.position > data.size()) scan = {body_begin, 0, false};
+			size_t position = scan.position;
+			std::string_view line;
+			while(!scan.trailers) {
+				if(!next_line(data, position, line)) return parse_incomplete;
+				if(http_detail::has_bare_cr(line)) return parse_invalid;
+				std::string_view const size_field = http_detail::trim(line.substr(0, line.find(';')));
+				size_t chunk_size = 0;
+				auto const [end, error] = std::from_chars(size_field.data(), size_field.data() + size_field.size(), chunk_size, 16);
+				if(error == std::errc::result_out_of_range || chunk_size > limits.max_body_size - scan.body_size) return parse_body_too_large;
+				if(size_field.empty() || error != std::errc() || end != size_field.data() + size_field.size()) return parse_invalid;
+				if(chunk_size == 0) scan.trailers = true;
+				else {
+					if(data.size() - position < chunk_size) return parse_incomplete;
+					position += chunk_size;
+					if(!next_line(data, position, line)) return parse_incomplete;
+					if(!line.empty()) return parse_invalid;
+					scan.body_size += chunk_size;
+					++scan.chunks;
+				}
+				scan.position = position;
+			}
+			// Trailer fields are accepted and dropped.
+			while(true) {
+				if(!next_line(data, position, line)) return parse_incomplete;
+				if(line.empty()) break;
+				if(http_detail::has_bare_cr(line)) return parse_invalid;
+				scan.position = position;
+			}
+
+			size_t const body_size = scan.body_size;
+			size_t cursor = body_begin;
+			size_t out = body_begin;
+			while(true) {
+				(void) next_line(data, cursor, line);
+				std::string_view const size_field = http_detail::trim(line.substr(0, line.find(';')));
+				size_t chunk_size = 0;
+				(void) std::from_chars(size_field.data(), size_field.data() + size_field.size(), chunk_size, 16);
+				if(chunk_size == 0) break;
+				::memmove(buffer.data() + out, buffer.data() + cursor, chunk_size);
+				out += chunk_size;
+				cursor += chunk_size;
+				(void) next_line(data, cursor, line);
+			}
+			request.body = data.substr(body_begin, body_size);
+			request.size = position;
+			return parse_complete;
+		}
+	};
+}
+
+#endif
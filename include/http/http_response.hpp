@@ -0,0 +1,115 @@
+#ifndef OFCT_NETWORK_http_http_response_hpp
+#define OFCT_NETWORK_http_http_response_hpp
+
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "http_request.hpp"
+
+namespace OFCT::networking {
+
+	constexpr std::string_view http_reason_phrase(unsigned code) {
+		switch(code) {
+		case 100: return "Continue";
+		case 101: return "Switching Protocols";
+		case 200: return "OK";
+		case 201: return "Created";
+		case 202: return "Accepted";
+		case 204: return "No Content";
+		case 206: return "Partial Content";
+		case 301: return "Moved Permanently";
+		case 302: return "Found";
+		case 303: return "See Other";
+		case 304: return "Not Modified";
+		case 307: return "Temporary Redirect";
+		case 308: return "Permanent Redirect";
+		case 400: return "Bad Request";
+		case 401: return "Unauthorized";
+		case 403: return "Forbidden";
+		case 404: return "Not Found";
+		case 405: return "Method Not Allowed";
+		case 408: return "Request Timeout";
+		case 409: return "Conflict";
+		case 411: return "Length Required";
+		case 413: return "Content Too Large";
+		case 414: return "URI Too Long";
+		case 415: return "Unsupported Media Type";
+		case 429: return "Too Many Requests";
+		case 431: return "Request Header Fields Too Large";
+		case 500: return "Internal Server Error";
+		case 501: return "Not Implemented";
+		case 502: return "Bad Gateway";
+		case 503: return "Service Unavailable";
+		case 504: return "Gateway Timeout";
+		case 505: return "HTTP Version Not Supported";
+		default: return "Unknown";
+		}
+	}
+
+	// Filled in by the service for one request and serialised by http_handler as soon as the service returns.
+	// Content-Length, Connection and Date are added by the handler.
+	class http_response {
+	public:
+		static constexpr size_t MAX_HEADERS = 32;
+
+		void set_status(unsigned code, std::string_view reason = {}) {
+			status_code = code;
+			reason_phrase = reason.empty() ? http_reason_phrase(code) : reason;
+		}
+
+		// Name and value are not copied and must stay valid until the service returns. False once MAX_HEADERS
+		// headers have been added.
+		bool add_header(std::string_view name, std::string_view value) {
+			if(header_count == MAX_HEADERS) return false;
+			headers[header_count++] = http_header{name, value};
+			return true;
+		}
+
+		// Sent straight from the caller's memory, without a copy; it has to stay valid until the response has
+		// been written, i.e. until the handler's next recv. Static content or a cache owned by the service qualify,
+		// and so does the request's own body.
+		void set_body(std::string_view body) {
+			borrowed_body = body;
+			owned_body.clear();
+		}
+
+		// Body built by the service; copied into the outgoing batch. The string is reused for every response on
+		// the connection, so it stops allocating once it has grown to the largest body.
+		[[nodiscard]] std::string &body_buffer() {
+			borrowed_body = {};
+			return owned_body;
+		}
+
+		// Ends the connection after this response.
+		void close() { keep_alive = false; }
+
+		[[nodiscard]] unsigned get_status_code() const { return status_code; }
+		[[nodiscard]] std::string_view get_reason_phrase() const { return reason_phrase; }
+		[[nodiscard]] std::span<http_header const> get_headers() const { return std::span(headers.data(), header_count); }
+		[[nodiscard]] std::string_view get_body() const { return borrowed_body.data() ? borrowed_body : std::string_view(owned_body); }
+		[[nodiscard]] bool is_body_borrowed() const { return borrowed_body.data() != nullptr; }
+		[[nodiscard]] bool is_keep_alive() const { return keep_alive; }
+
+		void reset() {
+			status_code = 200;
+			reason_phrase = "OK";
+			header_count = 0;
+			borrowed_body = {};
+			owned_body.clear();
+			keep_alive = true;
+		}
+
+	private:
+		unsigned status_code = 200;
+		std::string_view reason_phrase = "OK";
+		std::array<http_header, MAX_HEADERS> headers;
+		size_t header_count = 0;
+		std::string_view borrowed_body;
+		std::string owned_body;
+		bool keep_alive = true;
+	};
+}
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef OFCT_NETWORK_message_message_view_hpp
+#define OFCT_NETWORK_message_message_view_hpp
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+namespace OFCT::networking {
+
+	enum class byte_order { NONE, LITTLE, BIG };
+
+	constexpr auto byte_order_little = byte_order::LITTLE;
+	constexpr auto byte_order_big = byte_order::BIG;
+	constexpr auto byte_order_network = byte_order::BIG;
+
+	namespace message_detail {
+		template<typename T>
+		constexpr T byteswap(T value) {
+			if constexpr(sizeof(T) == 1) return value;
+			else {
+				using raw_t = std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+				raw_t raw = std::bit_cast<raw_t>(value);
+				if constexpr(sizeof(T) == 2) raw = __builtin_bswap16(raw);
+				else if constexpr(sizeof(T) == 4) raw = __builtin_bswap32(raw);
+				else raw = __builtin_bswap64(raw);
+				return std::bit_cast<T>(raw);
+			}
+		}
+
+		template<byte_order order>
+		constexpr bool is_native = (order == byte_order_little) == (std::endian::native == std::endian::little);
+	}
+
+	// Scalar at a fixed byte offset. Reads and writes go through memcpy, so any alignment is fine; a naturally
+	// aligned field in an aligned buffer compiles to a single load/store.
+	template<typename T, size_t offset, byte_order order = byte_order_network>
+	struct field {
+		static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "field type must be arithmetic or enum");
+		static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "unsupported field size");
+
+		using value_type = T;
+		static constexpr size_t begin = offset;
+		static constexpr size_t end = offset + sizeof(T);
+		static constexpr bool aligned = offset % alignof(T) == 0;
+
+		[[nodiscard]] static T load(uint8_t const *base) {
+			T value;
+			::memcpy(&value, base + offset, sizeof(T));
+			if constexpr(message_detail::is_native<order>) return value;
+			else return message_detail::byteswap(value);
+		}
+
+		static void store(uint8_t *base, T value) {
+			if constexpr(!message_detail::is_native<order>) value = message_detail::byteswap(value);
+			::memcpy(base + offset, &value, sizeof(T));
+		}
+	};
+
+	// Raw bytes at a fixed offset, exposed as a span into the buffer.
+	template<size_t offset, size_t length>
+	struct bytes_field {
+		using value_type = std::span<uint8_t const, length>;
+		static constexpr size_t begin = offset;
+		static constexpr size_t end = offset + length;
+
+		[[nodiscard]] static value_type load(uint8_t const *base) {
+			return value_type(base + offset, length);
+		}
+
+		static void store(uint8_t *base, std::span<uint8_t const, length> value) {
+			::memcpy(base + offset, value.data(), length);
+		}
+	};
+
+	// Fixed-size message layout; fields are checked at compile time to lie within the message and not overlap.
+	template<size_t message_size, typename... fields>
+	struct message_layout {
+		static constexpr size_t size = message_size;
+
+	private:
+		static constexpr bool in_bounds() {
+			return ((fields::end <= message_size) && ...);
+		}
+
+		static constexpr bool disjoint() {
+			constexpr size_t begins[] = {fields::begin..., 0};
+			constexpr size_t ends[] = {fields::end..., 0};
+			for(size_t i = 0; i < sizeof...(fields); ++i) {
+				for(size_t j = i + 1; j < sizeof...(fields); ++j) {
+					if(begins[i] < ends[j] && begins[j] < ends[i]) return false;
+				}
+			}
+			return true;
+		}
+
+		static_assert(in_bounds(), "message field exceeds the message size");
+		static_assert(disjoint(), "message fields overlap");
+
+	public:
+		template<typename target>
+		static constexpr bool contains = (std::is_same_v<target, fields> || ...);
+	};
+
+	// Read-only typed view over one message in a receive buffer; nothing is copied until a field is read.
+	template<typename layout>
+	class message_view {
+	public:
+		// Returns nothing when the buffer is too short to hold the message.
+		[[nodiscard]] static std::optional<message_view> parse(std::span<uint8_t const> buf) {
+			if(buf.size() < layout::size) return std::nullopt;
+			return message_view(buf.data());
+		}
+
+		template<typename target>
+		requires layout::template contains<target>
+		[[nodiscard]] typename target::value_type get() const {
+			return target::load(base);
+		}
+
+		[[nodiscard]] std::span<uint8_t const, layout::size> bytes() const {
+			return std::span<uint8_t const, layout::size>(base, layout::size);
+		}
+
+	private:
+		explicit message_view(uint8_t const *base) : base(base) {}
+
+		uint8_t const *base;
+	};
+
+	// Writable counterpart of message_view, for encoding straight into a send buffer.
+	template<typename layout>
+	class message_writer {
+	public:
+		[[nodiscard]] static std::optional<message_writer> wrap(std::span<uint8_t> buf) {
+			if(buf.size() < layout::size) return std::nullopt;
+			return message_writer(buf.data());
+		}
+
+		template<typename target>
+		requires layout::template contains<target>
+		[[nodiscard]] typename target::value_type get() const {
+			return target::load(base);
+		}
+
+		template<typename target, typename value_t>
+		requires layout::template contains<target>
+		message_writer &set(value_t const &value) {
+			target::store(base, value);
+			return *this;
+		}
+
+	private:
+		explicit message_writer(uint8_t *base) : base(base) {}
+
+		uint8_t *base;
+	};
+
+	// Walks consecutive fixed-size messages in a buffer; returns the number of bytes consumed, so a partial
+	// trailing message can be kept for the next recv.
+	template<typename layout, typename callback_t>
+	size_t for_each_message(std::span<uint8_t const> buf, callback_t &&callback) {
+		size_t offset = 0;
+		for(; offset + layout::size <= buf.size(); offset += layout::size) {
+			callback(*message_view<layout>::parse(buf.subspan(offset)));
+		}
+		return offset;
+	}
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef OFCT_NETWORK_numa_node_pool_hpp
+#define OFCT_NETWORK_numa_node_pool_hpp
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace OFCT::networking {
+
+	// Fixed-size blocks carved from one mapping whose pages are placed on a given NUMA node. Pages are
+	// faulted in by the constructor, so the placement holds even where mbind is unavailable, provided the
+	// pool is built on a thread already running on that node (first touch). Not thread-safe: meant to be
+	// owned by the worker pinned to the node.
+	class node_pool {
+		static constexpr size_t ALIGNMENT = 64;
+
+	public:
+		explicit node_pool(int node, size_t block_size, size_t block_count)
+		  : node(node), block_size((std::max(block_size, sizeof(void*)) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT),
+		    size(std::max<size_t>(this->block_size * block_count, 1)) {
+			void *const mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if(mapped == MAP_FAILED) throw std::bad_alloc();
+			base = static_cast<uint8_t*>(mapped);
+
+			// Preferred rather than bound: if the node runs out, allocation spills over instead of failing.
+			if(node >= 0) {
+				std::vector<unsigned long> mask(node / (8 * sizeof(unsigned long)) + 1);
+				mask[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+				bound = ::syscall(SYS_mbind, base, size, MPOL_PREFERRED, mask.data(), mask.size() * 8 * sizeof(unsigned long) + 1, 0) == 0;
+			}
+
+			long const page = ::sysconf(_SC_PAGESIZE);
+			for(size_t offset = 0; offset < size; offset += page) base[offset] = 0;
+
+			for(size_t i = block_count; i > 0; --i) deallocate(base + (i - 1) * this->block_size);
+		}
+
+		node_pool(node_pool const &) = delete;
+		node_pool &operator=(node_pool const &) = delete;
+
+		~node_pool() {
+			::munmap(base, size);
+		}
+
+		// nullptr when every block is in use.
+		[[nodiscard]] void *allocate() {
+			free_block *const block = free_list;
+			if(block) free_list = block->next;
+			return block;
+		}
+
+		void deallocate(void *ptr) {
+			free_block *const block = static_cast<free_block*>(ptr);
+			block->next = free_list;
+			free_list = block;
+		}
+
+		[[nodiscard]] int get_node() const { return node; }
+		[[nodiscard]] size_t get_block_size() const { return block_size; }
+		// Whether the kernel accepted the placement policy (false without NUMA support).
+		[[nodiscard]] bool is_bound() const { return bound; }
+
+	private:
+		struct free_block {
+			free_block *next;
+		};
+
+		int const node;
+		size_t const block_size;
+		size_t const size;
+		uint8_t *base = nullptr;
+		free_block *free_list = nullptr;
+		bool bound = false;
+	};
+}
+
+#endif
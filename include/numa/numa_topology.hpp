@@ -0,0 +1,116 @@
+#ifndef OFCT_NETWORK_numa_numa_topology_hpp
+#define OFCT_NETWORK_numa_numa_topology_hpp
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace OFCT::networking {
+
+	namespace numa_detail {
+		// sysfs CPU lists look like "0-3,8,10-11".
+		inline std::vector<int> parse_cpu_list(std::string_view list) {
+			std::vector<int> cpus;
+			while(!list.empty()) {
+				size_t const comma = list.find(',');
+				std::string const range(list.substr(0, comma));
+				list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+				char *end = nullptr;
+				long const first = std::strtol(range.c_str(), &end, 10);
+				if(end == range.c_str()) continue;
+				long const last = *end == '-' ? std::strtol(end + 1, nullptr, 10) : first;
+				for(long cpu = first; cpu <= last; ++cpu) cpus.push_back(static_cast<int>(cpu));
+			}
+			return cpus;
+		}
+
+		inline std::string read_line(std::string const &path) {
+			std::ifstream file(path);
+			std::string line;
+			std::getline(file, line);
+			return line;
+		}
+	}
+
+	// NUMA nodes and their CPUs as seen in sysfs, limited to the CPUs this process may run on. Hosts without
+	// /sys/devices/system/node (no NUMA support, or hidden in a container) come out as a single node 0 holding
+	// every usable CPU, so callers need no separate single-node path.
+	class numa_topology {
+	public:
+		struct node {
+			int id;
+			std::vector<int> cpus;
+		};
+
+		[[nodiscard]] static numa_topology detect() {
+			cpu_set_t allowed;
+			CPU_ZERO(&allowed);
+			bool const restricted = ::sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+			auto usable = [&](int cpu) { return !restricted || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)); };
+
+			numa_topology topology;
+			if(DIR *dir = ::opendir("/sys/devices/system/node")) {
+				while(dirent const *entry = ::readdir(dir)) {
+					std::string_view const name(entry->d_name);
+					if(name.size() <= 4 || name.substr(0, 4) != "node" || name.find_first_not_of("0123456789", 4) != std::string_view::npos) continue;
+					int const id = std::atoi(entry->d_name + 4);
+					std::vector<int> cpus = numa_detail::parse_cpu_list(numa_detail::read_line("/sys/devices/system/node/" + std::string(name) + "/cpulist"));
+					std::erase_if(cpus, [&](int cpu) { return !usable(cpu); });
+					// Memory-only nodes have no CPUs to place workers on.
+					if(!cpus.empty()) topology.nodes.push_back(node{id, std::move(cpus)});
+				}
+				::closedir(dir);
+			}
+			if(topology.nodes.empty()) {
+				std::vector<int> cpus = numa_detail::parse_cpu_list(numa_detail::read_line("/sys/devices/system/cpu/online"));
+				if(cpus.empty()) {
+					for(int cpu = 0; cpu < static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); ++cpu) cpus.push_back(cpu);
+				}
+				std::erase_if(cpus, [&](int cpu) { return !usable(cpu); });
+				topology.nodes.push_back(node{0, std::move(cpus)});
+			}
+			std::sort(topology.nodes.begin(), topology.nodes.end(), [](node const &a, node const &b) { return a.id < b.id; });
+			return topology;
+		}
+
+		[[nodiscard]] std::vector<node> const &get_nodes() const { return nodes; }
+		[[nodiscard]] size_t node_count() const { return nodes.size(); }
+		[[nodiscard]] bool is_numa() const { return nodes.size() > 1; }
+
+		// -1 if the CPU is not usable by this process.
+		[[nodiscard]] int node_of(int cpu) const {
+			for(node const &n : nodes) {
+				if(std::find(n.cpus.begin(), n.cpus.end(), cpu) != n.cpus.end()) return n.id;
+			}
+			return -1;
+		}
+
+		// Every usable CPU, grouped by node, so consecutive workers share a node.
+		[[nodiscard]] std::vector<int> cpus() const {
+			std::vector<int> result;
+			for(node const &n : nodes) result.insert(result.end(), n.cpus.begin(), n.cpus.end());
+			return result;
+		}
+
+	private:
+		std::vector<node> nodes;
+	};
+
+	// Restricts the calling thread to one CPU; false if the CPU is outside the allowed set.
+	[[nodiscard]] inline bool pin_current_thread(int cpu) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+	}
+}
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef OFCT_NETWORK_proxy_tcp_relay_hpp
+#define OFCT_NETWORK_proxy_tcp_relay_hpp
+
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+
+#include <csignal>
+#include <unordered_set>
+#include <vector>
+
+#include "upstream_selector.hpp"
+#include "../event/event_loop.hpp"
+#include "../socket/tcp_client.hpp"
+#include "../socket/tcp_listener.hpp"
+
+namespace OFCT::networking {
+
+	// L4 proxy: loop() accepts and pairs each connection with an upstream, relay_loop() moves the bytes.
+	// Both run on one thread each regardless of the number of connections; accepted pairs are handed to
+	// the relay thread through its event_loop. Data is spliced through a
+	// pipe per direction, so it never enters user space and the pipe size bounds the per-direction buffer;
+	// a full pipe stops reading from the source (backpressure), EOF is forwarded as shutdown(SHUT_WR).
+	template<upstream_balance balance>
+	class tcp_relay : public tcp_listener<sockaddr_type_in, false> {
+	public:
+		static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+		explicit tcp_relay(in_port_t port, in_addr_t ip, std::vector<upstream> upstreams,
+		                   size_t buffer_size = DEFAULT_BUFFER_SIZE, int backlog = std::numeric_limits<int>::max())
+		  : tcp_listener<sockaddr_type_in, false>(port, ip, backlog), selector(std::move(upstreams)), buffer_size(buffer_size) {}
+
+		explicit tcp_relay(in_port_t port, std::string_view ip_str, std::vector<upstream> upstreams,
+		                   size_t buffer_size = DEFAULT_BUFFER_SIZE, int backlog = std::numeric_limits<int>::max())
+		  : tcp_listener<sockaddr_type_in, false>(port, ip_str, backlog), selector(std::move(upstreams)), buffer_size(buffer_size) {}
+
+		// Both loop() and relay_loop() have to have returned by now.
+		~tcp_relay() override {
+			// Adopts sessions still queued for the relay thread so they are released below; no I/O is dispatched here.
+			io.drain();
+			for(relay_session *session : sessions) destroy(session);
+		}
+
+		void relay_loop(std::atomic_bool const &flag_quit) {
+			// splice() into a socket the peer has closed raises SIGPIPE; keep it pending on this thread instead.
+			sigset_t sigpipe;
+			::sigemptyset(&sigpipe);
+			::sigaddset(&sigpipe, SIGPIPE);
+			::pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+
+			io.run(flag_quit);
+		}
+
+		[[nodiscard]] size_t session_count() const { return sessions.size(); }
+
+	protected:
+		bool transceive(std::atomic_bool const &, tcp_transceiver<sockaddr_type_in, false> const &transceiver) final {
+			sockaddr_in peer_addr{};
+			socklen_t peer_addrlen = sizeof(peer_addr);
+			::getpeername(transceiver.native_handle(), reinterpret_cast<sockaddr*>(&peer_addr), &peer_addrlen);
+			upstream const &target = selector.select(ntohl(peer_addr.sin_addr.s_addr));
+
+			// The connect completes on the relay thread, so a slow upstream never holds up accepting.
+			tcp_client<sockaddr_type_in, false> client(target.port, target.ip);
+			::fcntl(client.native_handle(), F_SETFL, ::fcntl(client.native_handle(), F_GETFL, 0) | O_NONBLOCK);
+			bool const connected = client.connect();
+			if(!connected && errno != EINPROGRESS) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to connect to upstream; port = %hu, ip = %u\n", target.port, target.ip);
+				}
+				// Dropping the inbound connection is the answer to a dead upstream, not a listener failure.
+				return true;
+			}
+
+			// Both sockets close with their owners on return, so the session keeps duplicates.
+			auto *session = new relay_session{};
+			session->fd[0] = ::dup(transceiver.native_handle());
+			session->fd[1] = ::dup(client.native_handle());
+			session->dir[0].pipe[0] = session->dir[0].pipe[1] = -1;
+			session->dir[1].pipe[0] = session->dir[1].pipe[1] = -1;
+			session->connecting = !connected;
+			if(session->fd[0] == -1 || session->fd[1] == -1
+			   || ::pipe2(session->dir[0].pipe, O_NONBLOCK | O_CLOEXEC) == -1
+			   || ::pipe2(session->dir[1].pipe, O_NONBLOCK | O_CLOEXEC) == -1) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to set up relay session: errno = %d\n", errno);
+				}
+				destroy(session);
+				return true;
+			}
+
+			int const one = 1;
+			for(int i = 0; i < 2; ++i) {
+				::fcntl(session->fd[i], F_SETFL, ::fcntl(session->fd[i], F_GETFL, 0) | O_NONBLOCK);
+				::setsockopt(session->fd[i], IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+				::fcntl(session->dir[i].pipe[1], F_SETPIPE_SZ, static_cast<int>(buffer_size));
+				session->dir[i].capacity = static_cast<size_t>(::fcntl(session->dir[i].pipe[1], F_GETPIPE_SZ));
+				session->dir[i].src = session->fd[i];
+				session->dir[i].dst = session->fd[1 - i];
+				session->endpoint[i].owner = this;
+				session->endpoint[i].session = session;
+				session->endpoint[i].index = i;
+			}
+
+			if(!io.post([this, session]() { adopt(session); })) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Relay thread is saturated; dropping connection.\n");
+				}
+				destroy(session);
+			}
+			return true;
+		}
+
+	private:
+		struct relay_session;
+
+		struct relay_direction {
+			int src;
+			int dst;
+			int pipe[2];
+			size_t capacity;
+			size_t pending;
+			bool eof;
+			bool shut;
+		};
+
+		struct relay_endpoint : event_handler {
+			tcp_relay *owner = nullptr;
+			relay_session *session = nullptr;
+			int index = 0;
+			uint32_t events = 0;
+
+			void handle(uint32_t ready) final { owner->service(*this, ready); }
+		};
+
+		// dir[i] reads from fd[i] and writes to fd[1 - i].
+		struct relay_session {
+			int fd[2];
+			relay_direction dir[2];
+			relay_endpoint endpoint[2];
+			// The upstream connect is still in flight; the client side is not read until it completes.
+			bool connecting;
+			bool closed;
+		};
+
+		upstream_selector<balance> selector;
+		size_t buffer_size;
+		event_loop io;
+		// Owned by the relay_loop thread.
+		std::unordered_set<relay_session*> sessions;
+
+		void adopt(relay_session *session) {
+			sessions.insert(session);
+			for(auto &endpoint : session->endpoint) {
+				endpoint.events = interest(endpoint);
+				if(!io.add(session->fd[endpoint.index], endpoint.events, endpoint)) {
+					sessions.erase(session);
+					destroy(session);
+					return;
+				}
+			}
+		}
+
+		[[nodiscard]] static uint32_t interest(relay_endpoint const &endpoint) {
+			if(endpoint.session->connecting) return endpoint.index == 1 ? static_cast<uint32_t>(EPOLLOUT) : 0;
+			relay_direction const &in = endpoint.session->dir[endpoint.index];
+			relay_direction const &out = endpoint.session->dir[1 - endpoint.index];
+			uint32_t events = 0;
+			if(!in.eof && in.pending < in.capacity) events |= EPOLLIN;
+			if(out.pending) events |= EPOLLOUT;
+			return events;
+		}
+
+		// Returns false when the session has to be torn down.
+		[[nodiscard]] static bool pump(relay_direction &dir) {
+			if(!dir.eof && dir.pending < dir.capacity) {
+				ssize_t const received = ::splice(dir.src, nullptr, dir.pipe[1], nullptr, dir.capacity - dir.pending,
+				                                  SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+				if(received > 0) dir.pending += received;
+				else if(received == 0) dir.eof = true;
+				else if(errno != EAGAIN && errno != EWOULDBLOCK) return false;
+			}
+			if(dir.pending) {
+				ssize_t const sent = ::splice(dir.pipe[0], nullptr, dir.dst, nullptr, dir.pending,
+				                              SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+				if(sent > 0) dir.pending -= sent;
+				else if(sent == -1 && errno != EAGAIN && errno != EWOULDBLOCK) return false;
+			}
+			if(dir.eof && !dir.pending && !dir.shut) {
+				::shutdown(dir.dst, SHUT_WR);
+				dir.shut = true;
+			}
+			return true;
+		}
+
+		void service(relay_endpoint &endpoint, uint32_t events) {
+			relay_session *session = endpoint.session;
+			if(session->closed) return;
+			bool failed = (events & EPOLLERR) != 0;
+			if(!failed && session->connecting) {
+				// Until the connect completes only the upstream becoming writable, or the client resetting, matters.
+				if(endpoint.index == 0) {
+					if(!(events & EPOLLHUP)) return;
+					failed = true;
+				}
+				else {
+					int error = 0;
+					socklen_t error_len = sizeof(error);
+					failed = ::getsockopt(session->fd[1], SOL_SOCKET, SO_ERROR, &error, &error_len) == -1 || error != 0;
+					session->connecting = false;
+				}
+			}
+			if(failed || !pump(session->dir[0]) || !pump(session->dir[1])
+			   || (session->dir[0].shut && session->dir[1].shut)) {
+				// The other endpoint may still have an event pending in this batch.
+				session->closed = true;
+				sessions.erase(session);
+				io.defer([session]() { destroy(session); });
+				return;
+			}
+			for(auto &each : session->endpoint) {
+				uint32_t const wanted = interest(each);
+				if(wanted == each.events) continue;
+				each.events = wanted;
+				[[maybe_unused]] bool const modified = io.modify(session->fd[each.index], wanted, each);
+			}
+		}
+
+		// Closing the descriptors also removes them from the epoll set.
+		static void destroy(relay_session *session) {
+			for(int i = 0; i < 2; ++i) {
+				if(session->fd[i] != -1) ::close(session->fd[i]);
+				if(session->dir[i].pipe[0] != -1) ::close(session->dir[i].pipe[0]);
+				if(session->dir[i].pipe[1] != -1) ::close(session->dir[i].pipe[1]);
+			}
+			delete session;
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef OFCT_NETWORK_proxy_upstream_selector_hpp
+#define OFCT_NETWORK_proxy_upstream_selector_hpp
+
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace OFCT::networking {
+
+	// Host byte order, same as the tcp_socket(port, ip) constructors.
+	struct upstream {
+		in_port_t port;
+		in_addr_t ip;
+	};
+
+	enum class upstream_balance { NONE, ROUND_ROBIN, CONSISTENT_HASH };
+
+	constexpr auto balance_round_robin = upstream_balance::ROUND_ROBIN;
+	constexpr auto balance_consistent_hash = upstream_balance::CONSISTENT_HASH;
+
+	template<upstream_balance balance>
+	class upstream_selector;
+
+	template<>
+	class upstream_selector<balance_round_robin> {
+	public:
+		explicit upstream_selector(std::vector<upstream> upstreams) : upstreams(std::move(upstreams)) {}
+
+		[[nodiscard]] upstream const &select(in_addr_t) {
+			return upstreams[next.fetch_add(1, std::memory_order_relaxed) % upstreams.size()];
+		}
+
+	private:
+		std::vector<upstream> upstreams;
+		std::atomic_size_t next = 0;
+	};
+
+	// Ring of virtual nodes keyed by client address, so a client keeps its upstream and
+	// adding/removing an upstream only remaps ~1/n of the clients.
+	template<>
+	class upstream_selector<balance_consistent_hash> {
+		static constexpr size_t VIRTUAL_NODES = 128;
+
+	public:
+		explicit upstream_selector(std::vector<upstream> upstreams) : upstreams(std::move(upstreams)) {
+			ring.reserve(this->upstreams.size() * VIRTUAL_NODES);
+			for(size_t i = 0; i < this->upstreams.size(); ++i) {
+				uint64_t const key = static_cast<uint64_t>(this->upstreams[i].ip) << 16 | this->upstreams[i].port;
+				for(size_t v = 0; v < VIRTUAL_NODES; ++v) {
+					ring.emplace_back(mix(key << 8 ^ v), i);
+				}
+			}
+			std::sort(ring.begin(), ring.end());
+		}
+
+		[[nodiscard]] upstream const &select(in_addr_t client_ip) const {
+			uint64_t const hash = mix(client_ip);
+			auto it = std::lower_bound(ring.begin(), ring.end(), std::make_pair(hash, size_t(0)));
+			if(it == ring.end()) it = ring.begin();
+			return upstreams[it->second];
+		}
+
+	private:
+		std::vector<upstream> upstreams;
+		std::vector<std::pair<uint64_t, size_t>> ring;
+
+		// splitmix64 finalizer
+		static constexpr uint64_t mix(uint64_t x) {
+			x += 0x9e3779b97f4a7c15ULL;
+			x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+			return x ^ (x >> 31);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef OFCT_NETWORK_rpc_rpc_client_hpp
+#define OFCT_NETWORK_rpc_rpc_client_hpp
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <netinet/tcp.h>
+
+#include "rpc_frame.hpp"
+#include "../debug/debug_mode.hpp"
+#include "../socket/tcp_client.hpp"
+
+namespace OFCT::networking {
+
+	struct rpc_response {
+		rpc_status status;
+		std::vector<uint8_t> body;
+	};
+
+	// Request/response multiplexing over one connection. Every call gets an id, any number may be in flight,
+	// and responses complete their callbacks in whatever order the server sends them. Concurrent callers'
+	// frames are coalesced: whoever finds the socket idle sends everything queued so far in one send().
+	// Callbacks run on the reader thread; the body span is only valid during the callback.
+	class rpc_client {
+		static constexpr size_t READ_BUFFER_SIZE = 256 * 1024;
+
+	public:
+		using callback = std::function<void(rpc_status, std::span<uint8_t const>)>;
+
+		explicit rpc_client(in_port_t port, in_addr_t ip) : connection(port, ip) {}
+
+		explicit rpc_client(in_port_t port, std::string_view ip_str) : connection(port, ip_str) {}
+
+		rpc_client(rpc_client const &) = delete;
+		rpc_client &operator=(rpc_client const &) = delete;
+
+		~rpc_client() {
+			::shutdown(connection.native_handle(), SHUT_RDWR);
+			if(reader.joinable()) reader.join();
+		}
+
+		[[nodiscard]] bool connect() {
+			if(!connection.connect()) return false;
+			// Frames are already coalesced per send; Nagle would only add a delayed-ACK wait on top.
+			int const one = 1;
+			::setsockopt(connection.native_handle(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+			closed = false;
+			reader = std::thread([this]() { read_loop(); });
+			return true;
+		}
+
+		// Returns false if the connection is already gone, in which case done is never called. Otherwise done
+		// runs exactly once, with rpc_status_disconnected if the connection drops first.
+		[[nodiscard]] bool call(uint16_t method, std::span<uint8_t const> body, callback &&done) {
+			uint64_t const id = next_id.fetch_add(1, std::memory_order_relaxed);
+			{
+				std::lock_guard<std::mutex> lock(pending_mutex);
+				if(closed) return false;
+				pending.emplace(id, std::move(done));
+			}
+			submit(id, method, body);
+			return true;
+		}
+
+		[[nodiscard]] std::future<rpc_response> call(uint16_t method, std::span<uint8_t const> body) {
+			auto promise = std::make_shared<std::promise<rpc_response>>();
+			std::future<rpc_response> future = promise->get_future();
+			bool const submitted = call(method, body, [promise](rpc_status status, std::span<uint8_t const> response) {
+				promise->set_value(rpc_response{status, std::vector<uint8_t>(response.begin(), response.end())});
+			});
+			if(!submitted) promise->set_value(rpc_response{rpc_status_disconnected, {}});
+			return future;
+		}
+
+		[[nodiscard]] size_t in_flight() {
+			std::lock_guard<std::mutex> lock(pending_mutex);
+			return pending.size();
+		}
+
+	private:
+		tcp_client<sockaddr_type_in, false> connection;
+		std::thread reader;
+		std::atomic_uint64_t next_id = 1;
+
+		std::mutex pending_mutex;
+		std::unordered_map<uint64_t, callback> pending;
+		bool closed = true;
+
+		std::mutex send_mutex;
+		std::vector<uint8_t> outgoing;
+		// Only touched by the caller that set flushing.
+		std::vector<uint8_t> sending;
+		bool flushing = false;
+
+		void submit(uint64_t id, uint16_t method, std::span<uint8_t const> body) {
+			std::unique_lock<std::mutex> lock(send_mutex);
+			rpc_frame::append(outgoing, id, method, rpc_status_ok, body);
+			if(flushing) return;
+			flushing = true;
+			while(!outgoing.empty()) {
+				sending.swap(outgoing);
+				lock.unlock();
+				bool const sent = send_all(sending.data(), sending.size());
+				sending.clear();
+				lock.lock();
+				if(!sent) {
+					// The reader fails every pending call once the socket is shut down.
+					::shutdown(connection.native_handle(), SHUT_RDWR);
+					outgoing.clear();
+					break;
+				}
+			}
+			flushing = false;
+		}
+
+		// A peer that went away must fail the pending calls, not raise SIGPIPE in the caller.
+		[[nodiscard]] bool send_all(uint8_t const *buf, size_t len) const {
+			while(len > 0) {
+				ssize_t const sent = connection.send_raw(buf, len, MSG_NOSIGNAL);
+				if(sent < 0) {
+					if(errno == EINTR) continue;
+					return false;
+				}
+				buf += sent;
+				len -= sent;
+			}
+			return true;
+		}
+
+		void complete(uint64_t id, rpc_status status, std::span<uint8_t const> body) {
+			callback done;
+			{
+				std::lock_guard<std::mutex> lock(pending_mutex);
+				auto it = pending.find(id);
+				if(it == pending.end()) return;
+				done = std::move(it->second);
+				pending.erase(it);
+			}
+			done(status, body);
+		}
+
+		void read_loop() {
+			std::vector<uint8_t> buffer(READ_BUFFER_SIZE);
+			size_t filled = 0;
+			while(true) {
+				if(filled == buffer.size()) buffer.resize(buffer.size() * 2);
+				ssize_t const received = connection.recv_raw(buffer.data() + filled, buffer.size() - filled);
+				if(received <= 0) break;
+				filled += received;
+
+				size_t offset = 0;
+				bool corrupt = false;
+				while(auto header = message_view<rpc_frame::header>::parse(std::span(buffer).subspan(offset, filled - offset))) {
+					size_t const length = header->get<rpc_frame::length>();
+					if(length > rpc_frame::MAX_BODY_SIZE) {
+						corrupt = true;
+						break;
+					}
+					if(filled - offset < rpc_frame::HEADER_SIZE + length) {
+						if(buffer.size() < rpc_frame::HEADER_SIZE + length) buffer.resize(rpc_frame::HEADER_SIZE + length);
+						break;
+					}
+					complete(header->get<rpc_frame::request_id>(), header->get<rpc_frame::status>(),
+					         std::span<uint8_t const>(buffer.data() + offset + rpc_frame::HEADER_SIZE, length));
+					offset += rpc_frame::HEADER_SIZE + length;
+				}
+				if(corrupt) {
+					if constexpr(debug_mode) {
+						::fprintf(stderr, "Received a malformed RPC frame; closing.\n");
+					}
+					break;
+				}
+				::memmove(buffer.data(), buffer.data() + offset, filled - offset);
+				filled -= offset;
+			}
+
+			std::unordered_map<uint64_t, callback> failed;
+			{
+				std::lock_guard<std::mutex> lock(pending_mutex);
+				closed = true;
+				failed.swap(pending);
+			}
+			for(auto &[id, done] : failed) done(rpc_status_disconnected, {});
+		}
+	};
+}
+
+#endif
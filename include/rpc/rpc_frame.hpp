@@ -0,0 +1,44 @@
+#ifndef OFCT_NETWORK_rpc_rpc_frame_hpp
+#define OFCT_NETWORK_rpc_rpc_frame_hpp
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "../message/message_view.hpp"
+
+namespace OFCT::networking {
+
+	enum class rpc_status : uint16_t { OK, FAILED, UNKNOWN_METHOD, DISCONNECTED };
+
+	constexpr auto rpc_status_ok = rpc_status::OK;
+	constexpr auto rpc_status_failed = rpc_status::FAILED;
+	constexpr auto rpc_status_unknown_method = rpc_status::UNKNOWN_METHOD;
+	constexpr auto rpc_status_disconnected = rpc_status::DISCONNECTED;
+
+	// 16-byte header followed by `length` body bytes. Requests and responses share the format; a response
+	// echoes the request's id and method and fills in status.
+	struct rpc_frame {
+		using request_id = field<uint64_t, 0>;
+		using method = field<uint16_t, 8>;
+		using status = field<rpc_status, 10>;
+		using length = field<uint32_t, 12>;
+		using header = message_layout<16, request_id, method, status, length>;
+
+		static constexpr size_t HEADER_SIZE = header::size;
+		static constexpr size_t MAX_BODY_SIZE = 16 << 20;
+
+		static void append(std::vector<uint8_t> &out, uint64_t id, uint16_t method_id, rpc_status result, std::span<uint8_t const> body) {
+			size_t const offset = out.size();
+			out.resize(offset + HEADER_SIZE + body.size());
+			message_writer<header>::wrap(std::span(out).subspan(offset))
+			  ->set<request_id>(id)
+			  .set<method>(method_id)
+			  .set<status>(result)
+			  .set<length>(static_cast<uint32_t>(body.size()));
+			if(!body.empty()) ::memcpy(out.data() + offset + HEADER_SIZE, body.data(), body.size());
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef OFCT_NETWORK_rpc_rpc_handler_hpp
+#define OFCT_NETWORK_rpc_rpc_handler_hpp
+
+#include <concepts>
+#include <vector>
+
+#include "rpc_frame.hpp"
+#include "../socket/tcp_server.hpp"
+
+namespace OFCT::networking {
+
+	template<typename service_t>
+	concept rpc_service = requires(service_t &service, uint16_t method, std::span<uint8_t const> body, std::vector<uint8_t> &response) {
+		{ service(method, body, response) } -> std::same_as<rpc_status>;
+	};
+
+	// Server half of rpc_client, usable as a tcp_server handler. Every complete frame in a recv batch is
+	// handed to the service, and all of the batch's responses go back in a single send, so a pipelined
+	// client is answered at one syscall per batch rather than per request.
+	template<typename service_t>
+	requires rpc_service<service_t>
+	class rpc_handler {
+		static constexpr size_t READ_BUFFER_SIZE = 256 * 1024;
+
+	public:
+		explicit rpc_handler(service_t service) : service(std::move(service)) {}
+
+		template<sockaddr_type type, bool nonblocking>
+		bool transceive(std::atomic_bool const &flag_quit, tcp_transceiver<type, nonblocking> const &transceiver) {
+			std::vector<uint8_t> buffer(READ_BUFFER_SIZE);
+			std::vector<uint8_t> outgoing;
+			std::vector<uint8_t> response;
+			size_t filled = 0;
+			while(!flag_quit.load(std::memory_order_acquire)) {
+				if(filled == buffer.size()) buffer.resize(buffer.size() * 2);
+				ssize_t const received = transceiver.recv_raw(buffer.data() + filled, buffer.size() - filled);
+				if(received == 0) return true;
+				if(received < 0) {
+					if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+					return true;
+				}
+				filled += received;
+
+				size_t offset = 0;
+				while(auto header = message_view<rpc_frame::header>::parse(std::span(buffer).subspan(offset, filled - offset))) {
+					size_t const length = header->template get<rpc_frame::length>();
+					// A peer that does not speak the protocol just loses its connection.
+					if(length > rpc_frame::MAX_BODY_SIZE) return true;
+					if(filled - offset < rpc_frame::HEADER_SIZE + length) {
+						if(buffer.size() < rpc_frame::HEADER_SIZE + length) buffer.resize(rpc_frame::HEADER_SIZE + length);
+						break;
+					}
+					uint16_t const method = header->template get<rpc_frame::method>();
+					response.clear();
+					rpc_status const status = service(method, std::span<uint8_t const>(buffer.data() + offset + rpc_frame::HEADER_SIZE, length), response);
+					rpc_frame::append(outgoing, header->template get<rpc_frame::request_id>(), method, status, response);
+					offset += rpc_frame::HEADER_SIZE + length;
+				}
+				::memmove(buffer.data(), buffer.data() + offset, filled - offset);
+				filled -= offset;
+
+				if(!outgoing.empty()) {
+					if(!transceiver.send(outgoing.data(), outgoing.size())) return true;
+					outgoing.clear();
+				}
+			}
+			return true;
+		}
+
+		[[nodiscard]] service_t &get_service() { return service; }
+
+	private:
+		service_t service;
+	};
+}
+
+#endif
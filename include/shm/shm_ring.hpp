@@ -0,0 +1,196 @@
+#ifndef OFCT_NETWORK_shm_shm_ring_hpp
+#define OFCT_NETWORK_shm_shm_ring_hpp
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <thread>
+
+#include "../debug/debug_mode.hpp"
+
+namespace OFCT::networking {
+
+	// Control block at the start of each ring; lives in memory shared by both processes. Producer- and
+	// consumer-written words sit on separate cache lines.
+	struct shm_ring_header {
+		alignas(64) std::atomic_uint64_t head;
+		alignas(64) std::atomic_uint64_t tail;
+		// Set by a side about to sleep on it; the other side only makes the wake syscall when it is set.
+		alignas(64) std::atomic_uint32_t consumer_sleeping;
+		alignas(64) std::atomic_uint32_t producer_sleeping;
+		// Either side shuts the ring down; the consumer still drains what was written.
+		alignas(64) std::atomic_uint32_t closed;
+		uint64_t capacity;
+
+		static_assert(std::atomic_uint64_t::is_always_lock_free && std::atomic_uint32_t::is_always_lock_free,
+		              "shared-memory atomics must be lock-free");
+	};
+
+	// Single-producer single-consumer byte stream over a shm_ring_header and a power-of-two data area that
+	// follows it. Each process wraps the same memory; one is only ever the producer, the other the consumer.
+	// The peer can write anything into the shared header, so the capacity comes from the caller rather than
+	// from the header, and a fill level above it breaks the ring instead of being trusted.
+	class shm_ring {
+		static constexpr int SPIN_ITERATIONS = 256;
+		// Bounds a sleep so a peer that died without closing the ring is noticed.
+		static constexpr long SLEEP_NS = 100'000'000;
+
+	public:
+		static constexpr size_t footprint(size_t capacity) { return sizeof(shm_ring_header) + capacity; }
+
+		shm_ring() = default;
+
+		explicit shm_ring(void *base, size_t capacity) : header(static_cast<shm_ring_header*>(base)), data(static_cast<uint8_t*>(base) + sizeof(shm_ring_header)),
+		                                                 capacity(capacity), mask(capacity - 1) {}
+
+		// Creator only, before the memory is shared.
+		static void initialise(void *base, size_t capacity) {
+			shm_ring_header *header = new(base) shm_ring_header{};
+			header->capacity = capacity;
+		}
+
+		// Producer: copies up to len bytes; 0 if the ring is full or broken.
+		[[nodiscard]] size_t write_some(uint8_t const *buf, size_t len) {
+			if(broken) return 0;
+			uint64_t const head = header->head.load(std::memory_order_relaxed);
+			size_t space = capacity - used(head, cached_tail);
+			if(space < len) {
+				cached_tail = header->tail.load(std::memory_order_acquire);
+				space = capacity - used(head, cached_tail);
+			}
+			size_t const size = std::min<size_t>(len, space);
+			if(!size || broken) return 0;
+			size_t const offset = head & mask;
+			size_t const first = std::min<size_t>(size, capacity - offset);
+			::memcpy(data + offset, buf, first);
+			::memcpy(data, buf + first, size - first);
+			header->head.store(head + size, std::memory_order_release);
+			wake(header->consumer_sleeping);
+			return size;
+		}
+
+		// Consumer: copies up to len bytes; 0 if the ring is empty or broken.
+		[[nodiscard]] size_t read_some(uint8_t *buf, size_t len) {
+			if(broken) return 0;
+			uint64_t const tail = header->tail.load(std::memory_order_relaxed);
+			size_t available = used(cached_head, tail);
+			if(available < len) {
+				cached_head = header->head.load(std::memory_order_acquire);
+				available = used(cached_head, tail);
+			}
+			size_t const size = std::min<size_t>(len, available);
+			if(!size || broken) return 0;
+			size_t const offset = tail & mask;
+			size_t const first = std::min<size_t>(size, capacity - offset);
+			::memcpy(buf, data + offset, first);
+			::memcpy(buf + first, data, size - first);
+			header->tail.store(tail + size, std::memory_order_release);
+			wake(header->producer_sleeping);
+			return size;
+		}
+
+		// Spins briefly, then sleeps until data arrives or the ring is closed. Returns false if closed and
+		// drained, or if peer_alive() reports the peer gone.
+		template<typename alive_t>
+		[[nodiscard]] bool wait_readable(alive_t &&peer_alive) {
+			return wait(header->consumer_sleeping, [this]() {
+				return header->head.load(std::memory_order_acquire) != header->tail.load(std::memory_order_relaxed);
+			}, peer_alive);
+		}
+
+		// Returns false if the ring was closed or the peer is gone.
+		template<typename alive_t>
+		[[nodiscard]] bool wait_writable(alive_t &&peer_alive) {
+			// A corrupt fill level counts as ready, so the next write_some() notices it.
+			bool const ready = wait(header->producer_sleeping, [this]() {
+				return header->head.load(std::memory_order_relaxed) - header->tail.load(std::memory_order_acquire) != capacity;
+			}, peer_alive);
+			return ready && !is_closed();
+		}
+
+		void close() {
+			header->closed.store(1, std::memory_order_release);
+			wake(header->consumer_sleeping);
+			wake(header->producer_sleeping);
+		}
+
+		[[nodiscard]] bool is_closed() const { return header->closed.load(std::memory_order_acquire); }
+
+		// The peer left head and tail further apart than the capacity; the ring has been closed.
+		[[nodiscard]] bool is_broken() const { return broken; }
+
+	private:
+		shm_ring_header *header = nullptr;
+		uint8_t *data = nullptr;
+		uint64_t capacity = 0;
+		uint64_t mask = 0;
+		bool broken = false;
+		uint64_t cached_head = 0;
+		uint64_t cached_tail = 0;
+
+		[[nodiscard]] size_t used(uint64_t head, uint64_t tail) {
+			if(head - tail <= capacity) return head - tail;
+			if constexpr(debug_mode) {
+				::fprintf(stderr, "Shared ring is corrupt: head = %lu, tail = %lu, capacity = %lu\n", head, tail, capacity);
+			}
+			broken = true;
+			close();
+			return capacity;
+		}
+
+		static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+#elif defined(__aarch64__)
+			asm volatile("yield");
+#endif
+		}
+
+		// Pairs with the sleeper's flag store and recheck in wait(): either the sleeper sees our update, or we
+		// see its flag and wake it.
+		static void wake(std::atomic_uint32_t &sleeping) {
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(sleeping.load(std::memory_order_relaxed) && sleeping.exchange(0, std::memory_order_relaxed)) {
+				::syscall(SYS_futex, &sleeping, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+			}
+		}
+
+		template<typename ready_t, typename alive_t>
+		[[nodiscard]] bool wait(std::atomic_uint32_t &sleeping, ready_t &&ready, alive_t &&peer_alive) {
+			// On a single CPU the peer cannot make progress while we spin.
+			static int const spin = std::thread::hardware_concurrency() > 1 ? SPIN_ITERATIONS : 0;
+			for(int i = 0; i < spin; ++i) {
+				if(ready()) return true;
+				cpu_relax();
+			}
+			while(true) {
+				sleeping.store(1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if(ready()) {
+					sleeping.store(0, std::memory_order_relaxed);
+					return true;
+				}
+				if(is_closed()) {
+					sleeping.store(0, std::memory_order_relaxed);
+					return false;
+				}
+				timespec const timeout{0, SLEEP_NS};
+				// Not FUTEX_PRIVATE: the word is shared with another process.
+				if(::syscall(SYS_futex, &sleeping, FUTEX_WAIT, 1, &timeout, nullptr, 0) == -1 && errno == ETIMEDOUT && !peer_alive()) {
+					sleeping.store(0, std::memory_order_relaxed);
+					return ready();
+				}
+			}
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,308 @@
+#ifndef OFCT_NETWORK_shm_shm_transceiver_hpp
+#define OFCT_NETWORK_shm_shm_transceiver_hpp
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <bit>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "shm_ring.hpp"
+#include "../socket/socket_base.hpp"
+#include "../exceptions/shm_exceptions.hpp"
+
+namespace OFCT::networking {
+
+	namespace shm_detail {
+		constexpr uint32_t MAGIC = 0x4f464354;
+		constexpr uint32_t VERSION = 1;
+
+		// Sent by the listener together with the memfd.
+		struct offer_message {
+			uint32_t magic;
+			uint32_t version;
+			uint64_t capacity;
+		};
+
+		inline sockaddr_un make_address(std::string_view path) {
+			sockaddr_un addr{};
+			addr.sun_family = AF_UNIX;
+			::memcpy(addr.sun_path, path.data(), std::min(path.size(), sizeof(addr.sun_path) - 1));
+			return addr;
+		}
+	}
+
+	// Byte stream to a process on the same host through a pair of SPSC rings in a shared memfd, with the
+	// send/recv surface of tcp_transceiver. Data never goes through the kernel; a futex wake is only issued
+	// when the other side has gone to sleep waiting, so a busy pair exchanges data without syscalls. The AF_UNIX
+	// socket the rings were negotiated over stays open so a peer that dies is noticed.
+	//
+	// One thread may send while another receives; two concurrent senders (or receivers) are not supported.
+	class shm_transceiver : public socket_base<domain_unix, type_stream, protocol_default, false> {
+		friend class shm_listener;
+
+	protected:
+		static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+	public:
+		explicit shm_transceiver() : socket_base<domain_unix, type_stream, protocol_default, false>() {}
+
+		explicit shm_transceiver(int sockfd) : socket_base<domain_unix, type_stream, protocol_default, false>(sockfd) {}
+
+		shm_transceiver(shm_transceiver const &) = delete;
+		shm_transceiver &operator=(shm_transceiver const &) = delete;
+
+		~shm_transceiver() {
+			if(!mapping) return;
+			tx.close();
+			rx.close();
+			::munmap(mapping, mapping_size);
+		}
+
+		[[nodiscard]] bool is_attached() const { return mapping != nullptr; }
+
+		// Blocks until at least one byte fits (MSG_DONTWAIT: fails with EAGAIN instead); EPIPE once the peer is gone.
+		[[nodiscard]] ssize_t send_raw(void const *buf, size_t len, int flags = 0) const {
+			while(true) {
+				if(tx.is_closed()) {
+					errno = tx.is_broken() ? ECONNRESET : EPIPE;
+					return -1;
+				}
+				size_t const sent = tx.write_some(static_cast<uint8_t const*>(buf), len);
+				if(sent || !len) return static_cast<ssize_t>(sent);
+				if(tx.is_broken()) {
+					errno = ECONNRESET;
+					return -1;
+				}
+				if(flags & MSG_DONTWAIT) {
+					errno = EAGAIN;
+					return -1;
+				}
+				if(!tx.wait_writable([this]() { return peer_alive(); })) {
+					errno = EPIPE;
+					return -1;
+				}
+			}
+		}
+
+		// Blocks until at least one byte is available; 0 once the peer has closed and everything was read.
+		[[nodiscard]] ssize_t recv_raw(void *buf, size_t len, int flags = 0) const {
+			while(true) {
+				size_t const received = rx.read_some(static_cast<uint8_t*>(buf), len);
+				if(received || !len) return static_cast<ssize_t>(received);
+				if(rx.is_broken()) {
+					errno = ECONNRESET;
+					return -1;
+				}
+				if(flags & MSG_DONTWAIT) {
+					errno = EAGAIN;
+					return -1;
+				}
+				if(!rx.wait_readable([this]() { return peer_alive(); })) return static_cast<ssize_t>(rx.read_some(static_cast<uint8_t*>(buf), len));
+			}
+		}
+
+		[[nodiscard]] bool send(void const *buf, size_t len) const {
+			size_t offset = 0;
+			while(offset < len) {
+				ssize_t const sent = send_raw(static_cast<uint8_t const*>(buf) + offset, len - offset);
+				if(sent == -1) {
+					if constexpr(debug_mode) {
+						::fprintf(stderr, "Failed to send.\n");
+					}
+					return false;
+				}
+				offset += sent;
+			}
+			return true;
+		}
+
+		[[nodiscard]] bool send(std::string const &buf) const {
+			return send(buf.c_str(), buf.size());
+		}
+
+		[[nodiscard]] bool send(std::vector<uint8_t> const &buf) const {
+			return send(buf.data(), buf.size());
+		}
+
+		[[nodiscard]] bool recv(void *buf, size_t len) const {
+			size_t offset = 0;
+			while(offset < len) {
+				ssize_t const received = recv_raw(static_cast<uint8_t*>(buf) + offset, len - offset);
+				if(received <= 0) {
+					if constexpr(debug_mode) {
+						::fprintf(stderr, "Failed to receive.\n");
+					}
+					return false;
+				}
+				offset += received;
+			}
+			return true;
+		}
+
+		[[nodiscard]] bool recv(std::string &buf, size_t len) const {
+			buf.resize(len);
+			return recv(buf.data(), len);
+		}
+
+		[[nodiscard]] bool recv(std::vector<uint8_t> &buf, size_t len) const {
+			buf.resize(len);
+			return recv(buf.data(), len);
+		}
+
+	protected:
+		// Listener side: creates the rings and passes them over the control socket.
+		[[nodiscard]] bool offer(size_t capacity) {
+			capacity = std::bit_ceil(std::max<size_t>(capacity, 4096));
+			int const memfd = ::memfd_create("ofct_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+			if(memfd == -1) return false;
+			size_t const size = 2 * shm_ring::footprint(capacity);
+			// Sealed so the peer cannot shrink the file under our mapping.
+			bool const mapped = ::ftruncate(memfd, static_cast<off_t>(size)) == 0
+			                 && ::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == 0
+			                 && map(memfd, capacity, true);
+			bool const sent = mapped && send_offer(memfd, capacity);
+			::close(memfd);
+			return sent;
+		}
+
+		// Client side: receives the rings offered by the listener.
+		[[nodiscard]] bool attach() {
+			shm_detail::offer_message message{};
+			int const memfd = recv_offer(message);
+			if(memfd == -1) return false;
+			// Without these seals the peer could shrink the file under our mapping and fault us with SIGBUS.
+			int const required_seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+			int const seals = ::fcntl(memfd, F_GET_SEALS);
+			struct stat st{};
+			bool const valid = message.magic == shm_detail::MAGIC && message.version == shm_detail::VERSION
+			                && std::has_single_bit(message.capacity) && seals != -1 && (seals & required_seals) == required_seals
+			                && ::fstat(memfd, &st) == 0 && message.capacity <= static_cast<size_t>(st.st_size) / 2
+			                && static_cast<size_t>(st.st_size) >= 2 * shm_ring::footprint(message.capacity);
+			bool const mapped = valid && map(memfd, message.capacity, false);
+			::close(memfd);
+			return mapped;
+		}
+
+	private:
+		mutable shm_ring tx;
+		mutable shm_ring rx;
+		void *mapping = nullptr;
+		size_t mapping_size = 0;
+
+		[[nodiscard]] bool peer_alive() const {
+			pollfd pfd{sockfd, POLLRDHUP, 0};
+			return ::poll(&pfd, 1, 0) == 0;
+		}
+
+		// The listener produces into the first ring and consumes from the second; the client the other way round.
+		[[nodiscard]] bool map(int memfd, size_t capacity, bool creator) {
+			size_t const size = 2 * shm_ring::footprint(capacity);
+			void *const base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, memfd, 0);
+			if(base == MAP_FAILED) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to map shared rings: errno = %d\n", errno);
+				}
+				return false;
+			}
+			uint8_t *const first = static_cast<uint8_t*>(base);
+			uint8_t *const second = first + shm_ring::footprint(capacity);
+			if(creator) {
+				shm_ring::initialise(first, capacity);
+				shm_ring::initialise(second, capacity);
+			}
+			tx = shm_ring(creator ? first : second, capacity);
+			rx = shm_ring(creator ? second : first, capacity);
+			mapping = base;
+			mapping_size = size;
+			return true;
+		}
+
+		[[nodiscard]] bool send_offer(int memfd, size_t capacity) const {
+			shm_detail::offer_message message{shm_detail::MAGIC, shm_detail::VERSION, capacity};
+			alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+			iovec iov{&message, sizeof(message)};
+			msghdr msg{};
+			msg.msg_iov = &iov;
+			msg.msg_iovlen = 1;
+			msg.msg_control = control;
+			msg.msg_controllen = sizeof(control);
+			cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+			cmsg->cmsg_level = SOL_SOCKET;
+			cmsg->cmsg_type = SCM_RIGHTS;
+			cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+			::memcpy(CMSG_DATA(cmsg), &memfd, sizeof(int));
+			return ::sendmsg(sockfd, &msg, MSG_NOSIGNAL) == sizeof(message);
+		}
+
+		[[nodiscard]] int recv_offer(shm_detail::offer_message &message) const {
+			alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+			iovec iov{&message, sizeof(message)};
+			msghdr msg{};
+			msg.msg_iov = &iov;
+			msg.msg_iovlen = 1;
+			msg.msg_control = control;
+			msg.msg_controllen = sizeof(control);
+			if(::recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL) != sizeof(message)) return -1;
+			cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+			if(cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) return -1;
+			int memfd;
+			::memcpy(&memfd, CMSG_DATA(cmsg), sizeof(int));
+			return memfd;
+		}
+	};
+
+	// Accepts shm_transceiver peers on an AF_UNIX path.
+	class shm_listener : public socket_base<domain_unix, type_stream, protocol_default, false> {
+	public:
+		explicit shm_listener(std::string_view path, size_t capacity = shm_transceiver::DEFAULT_CAPACITY, int backlog = SOMAXCONN)
+		  : socket_base<domain_unix, type_stream, protocol_default, false>(), addr(shm_detail::make_address(path)), capacity(capacity) {
+			::unlink(addr.sun_path);
+			if(::bind(sockfd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) == -1 || ::listen(sockfd, backlog) == -1) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to bind shared-memory control socket %s: errno = %d\n", addr.sun_path, errno);
+				}
+				throw shm_bind_failure_exception(path);
+			}
+		}
+
+		~shm_listener() {
+			::unlink(addr.sun_path);
+		}
+
+		// nullptr if accepting or setting up the rings failed.
+		[[nodiscard]] std::unique_ptr<shm_transceiver> accept() const {
+			int const peer = ::accept4(sockfd, nullptr, nullptr, SOCK_CLOEXEC);
+			if(peer == -1) return nullptr;
+			auto transceiver = std::make_unique<shm_transceiver>(peer);
+			if(!transceiver->offer(capacity)) return nullptr;
+			return transceiver;
+		}
+
+	private:
+		sockaddr_un addr;
+		size_t capacity;
+	};
+
+	class shm_client : public shm_transceiver {
+	public:
+		explicit shm_client(std::string_view path) : shm_transceiver(), addr(shm_detail::make_address(path)) {}
+
+		[[nodiscard]] bool connect() {
+			return !::connect(sockfd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) && attach();
+		}
+
+	private:
+		sockaddr_un addr;
+	};
+}
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef OFCT_NETWORK_socket_admission_control_hpp
+#define OFCT_NETWORK_socket_admission_control_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace OFCT::networking {
+
+	enum class rejection_mode { NONE, FAST_CLOSE, BUSY_REPLY };
+
+	// FAST_CLOSE resets the connection (SO_LINGER 0); BUSY_REPLY writes busy_reply first, without blocking.
+	constexpr auto rejection_fast_close = rejection_mode::FAST_CLOSE;
+	constexpr auto rejection_busy_reply = rejection_mode::BUSY_REPLY;
+
+	// A rate of 0 means unlimited.
+	class token_bucket {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		explicit token_bucket(double rate = 0, double burst = 1, clock::time_point now = clock::now())
+		  : rate(rate), burst(std::max(burst, 1.0)), tokens(this->burst), last(now) {}
+
+		[[nodiscard]] bool try_acquire(clock::time_point now) {
+			if(rate <= 0) return true;
+			refill(now);
+			if(tokens < 1) return false;
+			tokens -= 1;
+			return true;
+		}
+
+		// Whether the bucket would be back at its burst size by now, i.e. forgetting it changes nothing.
+		[[nodiscard]] bool idle(clock::time_point now) const {
+			return rate <= 0 || tokens + std::chrono::duration<double>(now - last).count() * rate >= burst;
+		}
+
+	private:
+		double rate;
+		double burst;
+		double tokens;
+		clock::time_point last;
+
+		void refill(clock::time_point now) {
+			tokens = std::min(burst, tokens + std::chrono::duration<double>(now - last).count() * rate);
+			last = now;
+		}
+	};
+
+	// Zero disables the corresponding limit, except for max_queued.
+	struct admission_limits {
+		// Connections queued or being served.
+		size_t max_connections = 0;
+		// Connections accepted but not yet picked up by a worker (blocking listener only). Always enforced, so
+		// the queue stays bounded even without max_connections.
+		size_t max_queued = 4096;
+		// Requests between try_begin_request() and end_request(), across all connections. The listener does
+		// not enforce it; it only limits handlers that take a request_slot per request.
+		size_t max_in_flight = 0;
+		double listener_rate = 0;
+		double listener_burst = 1;
+		double peer_rate = 0;
+		double peer_burst = 1;
+		// Queue delay targets for shedding; a zero target disables it.
+		std::chrono::microseconds target_delay = std::chrono::milliseconds(5);
+		std::chrono::microseconds interval = std::chrono::milliseconds(100);
+		rejection_mode on_reject = rejection_fast_close;
+		std::string busy_reply;
+		// Threads serving connections out of the admission queue (blocking listener only).
+		size_t workers = 1;
+	};
+
+	// Overload protection consulted by tcp_listener's admission loop. Connections are checked against the
+	// caps and token buckets as soon as they are accepted, and shed on dequeue when they have waited too long.
+	//
+	// Shedding follows the CoDel variant used for server request queues: if the smallest queue delay seen over
+	// a whole interval stayed above target, the queue is standing rather than absorbing a burst, and anything
+	// that waited longer than target is rejected; otherwise only connections older than interval are.
+	class admission_control {
+		static constexpr size_t PEER_TABLE_SWEEP = 4096;
+
+	public:
+		using clock = std::chrono::steady_clock;
+
+		explicit admission_control(admission_limits limits)
+		  : limits(std::move(limits)), listener_bucket(this->limits.listener_rate, this->limits.listener_burst) {}
+
+		admission_control(admission_control const &) = delete;
+		admission_control &operator=(admission_control const &) = delete;
+
+		// Accept-thread only. On success the caller owns a connection slot until release_connection().
+		[[nodiscard]] bool admit(in_addr_t peer_ip, clock::time_point now) {
+			if(limits.max_connections && connections.load(std::memory_order_relaxed) >= limits.max_connections) {
+				rejected_limit.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			if(!listener_bucket.try_acquire(now) || (limits.peer_rate > 0 && !peer_bucket(peer_ip, now).try_acquire(now))) {
+				rejected_rate.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			connections.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		void release_connection() {
+			connections.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		// Accept-thread only. Turns away a connection admit() let in but the listener had no room to queue,
+		// counting it against the limits and giving its slot back.
+		void reject_unqueued(int sockfd) {
+			rejected_limit.fetch_add(1, std::memory_order_relaxed);
+			reject(sockfd);
+			release_connection();
+		}
+
+		// Decides for a connection leaving the queue after waiting `sojourn`. Callers serialise calls (the
+		// listener holds its queue lock).
+		[[nodiscard]] bool should_shed(clock::duration sojourn, clock::time_point now) {
+			if(limits.target_delay.count() == 0) return false;
+			if(now >= interval_end) {
+				overloaded = interval_min > limits.target_delay;
+				interval_min = clock::duration::max();
+				interval_end = now + limits.interval;
+			}
+			interval_min = std::min(interval_min, sojourn);
+			if(sojourn <= (overloaded ? clock::duration(limits.target_delay) : clock::duration(limits.interval))) return false;
+			shed.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		[[nodiscard]] bool try_begin_request() {
+			size_t const previous = in_flight.fetch_add(1, std::memory_order_relaxed);
+			if(!limits.max_in_flight || previous < limits.max_in_flight) return true;
+			in_flight.fetch_sub(1, std::memory_order_relaxed);
+			rejected_limit.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		void end_request() {
+			in_flight.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		// Turns the connection away as configured and closes it.
+		void reject(int sockfd) const {
+			if(limits.on_reject == rejection_busy_reply && !limits.busy_reply.empty()) {
+				(void) ::send(sockfd, limits.busy_reply.data(), limits.busy_reply.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+			}
+			else {
+				linger const reset{1, 0};
+				::setsockopt(sockfd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+			}
+			::close(sockfd);
+		}
+
+		[[nodiscard]] admission_limits const &get_limits() const { return limits; }
+		[[nodiscard]] size_t connection_count() const { return connections.load(std::memory_order_relaxed); }
+		[[nodiscard]] size_t in_flight_count() const { return in_flight.load(std::memory_order_relaxed); }
+		[[nodiscard]] uint64_t rejected_limit_count() const { return rejected_limit.load(std::memory_order_relaxed); }
+		[[nodiscard]] uint64_t rejected_rate_count() const { return rejected_rate.load(std::memory_order_relaxed); }
+		[[nodiscard]] uint64_t shed_count() const { return shed.load(std::memory_order_relaxed); }
+
+	private:
+		admission_limits const limits;
+		token_bucket listener_bucket;
+		std::unordered_map<in_addr_t, token_bucket> peers;
+
+		clock::time_point interval_end{};
+		clock::duration interval_min = clock::duration::max();
+		bool overloaded = false;
+
+		std::atomic_size_t connections = 0;
+		std::atomic_size_t in_flight = 0;
+		std::atomic_uint64_t rejected_limit = 0;
+		std::atomic_uint64_t rejected_rate = 0;
+		std::atomic_uint64_t shed = 0;
+
+		token_bucket &peer_bucket(in_addr_t peer_ip, clock::time_point now) {
+			// Buckets that have refilled carry no state, so the table only holds recently active peers.
+			if(peers.size() >= PEER_TABLE_SWEEP && !peers.contains(peer_ip)) {
+				std::erase_if(peers, [now](auto const &entry) { return entry.second.idle(now); });
+			}
+			return peers.try_emplace(peer_ip, limits.peer_rate, limits.peer_burst, now).first->second;
+		}
+	};
+
+	// Holds one of admission_control's in-flight request slots for a scope.
+	class request_slot {
+	public:
+		explicit request_slot(admission_control &admission) : admission(admission), acquired(admission.try_begin_request()) {}
+
+		request_slot(request_slot const &) = delete;
+		request_slot &operator=(request_slot const &) = delete;
+
+		~request_slot() {
+			if(acquired) admission.end_request();
+		}
+
+		[[nodiscard]] explicit operator bool() const { return acquired; }
+
+	private:
+		admission_control &admission;
+		bool const acquired;
+	};
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef OFCT_NETWORK_socket_fd_handoff_hpp
+#define OFCT_NETWORK_socket_fd_handoff_hpp
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "socket_base.hpp"
+
+namespace OFCT::networking {
+
+	// Passes listening sockets from a running process to its replacement over a Unix socket with SCM_RIGHTS,
+	// so the accept queue survives a restart. The old process calls offer() on a control path, the new one
+	// take() on the same path; the new process then builds its listeners with tcp_listener(inherit_socket, fd),
+	// which accepts listening sockets only. The kernel socket is shared until the old process closes its
+	// copies, so it should stop accepting once offer() returns.
+	class fd_handoff : public socket_base<domain_unix, type_stream, protocol_default, false> {
+		// SCM_MAX_FD
+		static constexpr size_t MAX_FDS_PER_MESSAGE = 253;
+
+	public:
+		explicit fd_handoff(std::string_view path) : socket_base<domain_unix, type_stream, protocol_default, false>() {
+			::memset(&addr, 0, sizeof(addr));
+			addr.sun_family = AF_UNIX;
+			::memcpy(addr.sun_path, path.data(), std::min(path.size(), sizeof(addr.sun_path) - 1));
+		}
+
+		// Old process: waits for the successor on the control path and sends it fds. Returns after the successor
+		// acknowledged receipt, so the caller may stop serving right away. Only a peer running as peer_uid gets
+		// the fds; anyone else who connects to the path is hung up on and offer() keeps waiting.
+		[[nodiscard]] bool offer(std::vector<int> const &fds, uid_t peer_uid = ::geteuid()) const {
+			::unlink(addr.sun_path);
+			if(::bind(sockfd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) == -1 || ::listen(sockfd, 1) == -1) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to listen on handoff path %s: errno = %d\n", addr.sun_path, errno);
+				}
+				return false;
+			}
+			int peer;
+			while(true) {
+				peer = ::accept4(sockfd, nullptr, nullptr, SOCK_CLOEXEC);
+				if(peer == -1) {
+					if(errno == EINTR || errno == ECONNABORTED) continue;
+					break;
+				}
+				ucred credentials{};
+				socklen_t credentials_len = sizeof(credentials);
+				if(::getsockopt(peer, SOL_SOCKET, SO_PEERCRED, &credentials, &credentials_len) == 0 && credentials.uid == peer_uid) break;
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Refused handoff to uid %u on %s.\n", credentials.uid, addr.sun_path);
+				}
+				::close(peer);
+			}
+			::unlink(addr.sun_path);
+			if(peer == -1) return false;
+
+			bool result = send_fds(peer, fds);
+			uint8_t ack = 0;
+			result = result && ::recv(peer, &ack, sizeof(ack), MSG_WAITALL) == sizeof(ack) && ack == 1;
+			::close(peer);
+			return result;
+		}
+
+		// New process: connects to the control path and receives the predecessor's fds, in offer() order.
+		[[nodiscard]] bool take(std::vector<int> &fds) const {
+			if(::connect(sockfd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) == -1) return false;
+			if(!recv_fds(sockfd, fds)) return false;
+			uint8_t const ack = 1;
+			return ::send(sockfd, &ack, sizeof(ack), MSG_NOSIGNAL) == sizeof(ack);
+		}
+
+	private:
+		sockaddr_un addr;
+
+		// A count goes first, then the fds in chunks of at most SCM_MAX_FD, one byte of data each.
+		[[nodiscard]] static bool send_fds(int sock, std::vector<int> const &fds) {
+			uint32_t const count = static_cast<uint32_t>(fds.size());
+			if(::send(sock, &count, sizeof(count), MSG_NOSIGNAL) != sizeof(count)) return false;
+			for(size_t offset = 0; offset < fds.size(); offset += MAX_FDS_PER_MESSAGE) {
+				size_t const chunk = std::min(MAX_FDS_PER_MESSAGE, fds.size() - offset);
+				alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS_PER_MESSAGE)]{};
+				char data = 0;
+				iovec iov{&data, sizeof(data)};
+				msghdr msg{};
+				msg.msg_iov = &iov;
+				msg.msg_iovlen = 1;
+				msg.msg_control = control;
+				msg.msg_controllen = CMSG_SPACE(sizeof(int) * chunk);
+				cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+				cmsg->cmsg_level = SOL_SOCKET;
+				cmsg->cmsg_type = SCM_RIGHTS;
+				cmsg->cmsg_len = CMSG_LEN(sizeof(int) * chunk);
+				::memcpy(CMSG_DATA(cmsg), fds.data() + offset, sizeof(int) * chunk);
+				if(::sendmsg(sock, &msg, MSG_NOSIGNAL) != sizeof(data)) {
+					if constexpr(debug_mode) {
+						::fprintf(stderr, "Failed to send fds: errno = %d\n", errno);
+					}
+					return false;
+				}
+			}
+			return true;
+		}
+
+		[[nodiscard]] static bool recv_fds(int sock, std::vector<int> &fds) {
+			uint32_t count = 0;
+			if(::recv(sock, &count, sizeof(count), MSG_WAITALL) != sizeof(count)) return false;
+			fds.clear();
+			fds.reserve(count);
+			while(fds.size() < count) {
+				alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS_PER_MESSAGE)]{};
+				char data;
+				iovec iov{&data, sizeof(data)};
+				msghdr msg{};
+				msg.msg_iov = &iov;
+				msg.msg_iovlen = 1;
+				msg.msg_control = control;
+				msg.msg_controllen = sizeof(control);
+				if(::recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) != sizeof(data)) break;
+				for(cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+					if(cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+					size_t const received = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+					for(size_t i = 0; i < received; ++i) {
+						int fd;
+						::memcpy(&fd, CMSG_DATA(cmsg) + sizeof(int) * i, sizeof(int));
+						fds.push_back(fd);
+					}
+				}
+				if(msg.msg_flags & MSG_CTRUNC) break;
+			}
+			if(fds.size() != count) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Received %zu of %u fds.\n", fds.size(), count);
+				}
+				for(int fd : fds) ::close(fd);
+				fds.clear();
+				return false;
+			}
+			return true;
+		}
+	};
+}
+
+#endif
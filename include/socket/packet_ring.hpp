@@ -0,0 +1,203 @@
+#ifndef OFCT_NETWORK_socket_packet_ring_hpp
+#define OFCT_NETWORK_socket_packet_ring_hpp
+
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "socket_base.hpp"
+#include "../exceptions/packet_exceptions.hpp"
+
+namespace OFCT::networking {
+
+	enum class packet_fanout { NONE, HASH, LOAD_BALANCE, CPU, ROLLOVER, RANDOM, QUEUE_MAPPING };
+
+	constexpr auto fanout_none = packet_fanout::NONE;
+	constexpr auto fanout_hash = packet_fanout::HASH;
+	constexpr auto fanout_load_balance = packet_fanout::LOAD_BALANCE;
+	constexpr auto fanout_cpu = packet_fanout::CPU;
+	constexpr auto fanout_rollover = packet_fanout::ROLLOVER;
+	constexpr auto fanout_random = packet_fanout::RANDOM;
+	constexpr auto fanout_queue_mapping = packet_fanout::QUEUE_MAPPING;
+
+	constexpr int packet_fanout_to_PACKET_FANOUT(packet_fanout fanout) {
+		switch(fanout) {
+		case fanout_hash: return PACKET_FANOUT_HASH;
+		case fanout_load_balance: return PACKET_FANOUT_LB;
+		case fanout_cpu: return PACKET_FANOUT_CPU;
+		case fanout_rollover: return PACKET_FANOUT_ROLLOVER;
+		case fanout_random: return PACKET_FANOUT_RND;
+		case fanout_queue_mapping: return PACKET_FANOUT_QM;
+		default: return -1;
+		}
+	}
+
+	struct packet_ring_options {
+		// Empty captures on every interface.
+		std::string interface;
+		// A multiple of the page size; a block is the unit handed between kernel and user space.
+		uint32_t block_size = 1 << 20;
+		uint32_t block_count = 64;
+		// Upper bound on one packet's slot in a block (TPACKET_V3 packs packets, it does not use fixed frames).
+		uint32_t frame_size = 2048;
+		// A partly filled block is retired to user space after this long, so light traffic is not held back.
+		uint32_t block_timeout_ms = 10;
+		bool promiscuous = false;
+		// Skips packets this host transmits; on loopback every packet would otherwise be seen twice. The kernel
+		// does not apply this to fanout members, which have to filter on captured_packet::packet_type instead.
+		bool ignore_outgoing = false;
+		// Rings sharing a fanout group on the same interface split its traffic between them, e.g. one per thread.
+		packet_fanout fanout = fanout_none;
+		uint16_t fanout_group = 0;
+	};
+
+	// One packet in a retired block; valid until the callback returns.
+	struct captured_packet {
+		// From the link-layer header on, snap length bytes.
+		std::span<uint8_t const> data;
+		uint32_t wire_length;
+		uint32_t sec;
+		uint32_t nsec;
+		uint32_t rxhash;
+		int ifindex;
+		// PACKET_HOST, PACKET_OUTGOING, ...
+		uint8_t packet_type;
+	};
+
+	// AF_PACKET receive socket with a memory-mapped TPACKET_V3 ring. The kernel fills whole blocks of packets
+	// and flips their status word; poll() only enters the kernel when the next block is not ready yet, so a
+	// busy capture costs one syscall per block instead of one per packet.
+	class packet_ring : public socket_base<domain_packet, type_raw, protocol_default, false> {
+	public:
+		explicit packet_ring(packet_ring_options const &options) : socket_base<domain_packet, type_raw, protocol_default, false>(),
+		                                                           block_size(options.block_size), block_count(options.block_count) {
+			// Created with protocol 0, the socket receives nothing until bind below, i.e. until the ring exists.
+			int const version = TPACKET_V3;
+			setup(::setsockopt(sockfd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)), "PACKET_VERSION");
+
+			tpacket_req3 request{};
+			request.tp_block_size = block_size;
+			request.tp_block_nr = block_count;
+			request.tp_frame_size = options.frame_size;
+			request.tp_frame_nr = static_cast<unsigned>(static_cast<uint64_t>(block_size) * block_count / options.frame_size);
+			request.tp_retire_blk_tov = options.block_timeout_ms;
+			request.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+			setup(::setsockopt(sockfd, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)), "PACKET_RX_RING");
+
+			void *const mapped = ::mmap(nullptr, map_size(), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, sockfd, 0);
+			setup(mapped == MAP_FAILED ? -1 : 0, "mmap");
+			ring = static_cast<uint8_t*>(mapped);
+
+			if(options.ignore_outgoing) {
+				int const one = 1;
+				setup(::setsockopt(sockfd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &one, sizeof(one)), "PACKET_IGNORE_OUTGOING");
+			}
+
+			sockaddr_ll addr{};
+			addr.sll_family = AF_PACKET;
+			addr.sll_protocol = htons(ETH_P_ALL);
+			if(!options.interface.empty()) {
+				addr.sll_ifindex = static_cast<int>(::if_nametoindex(options.interface.c_str()));
+				setup(addr.sll_ifindex == 0 ? -1 : 0, "if_nametoindex");
+			}
+			setup(::bind(sockfd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)), "bind");
+
+			if(options.promiscuous && addr.sll_ifindex) {
+				packet_mreq membership{};
+				membership.mr_ifindex = addr.sll_ifindex;
+				membership.mr_type = PACKET_MR_PROMISC;
+				setup(::setsockopt(sockfd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &membership, sizeof(membership)), "PACKET_ADD_MEMBERSHIP");
+			}
+
+			// Fanout has to be joined after bind.
+			if(options.fanout != fanout_none) {
+				int const fanout = options.fanout_group | packet_fanout_to_PACKET_FANOUT(options.fanout) << 16;
+				setup(::setsockopt(sockfd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)), "PACKET_FANOUT");
+			}
+		}
+
+		packet_ring(packet_ring const &) = delete;
+		packet_ring &operator=(packet_ring const &) = delete;
+
+		~packet_ring() {
+			if(ring) ::munmap(ring, map_size());
+		}
+
+		// Waits up to timeout_ms (-1: forever) for the next block, passes each of its packets to
+		// callback(captured_packet const&) and returns the block to the kernel. Returns the number of packets,
+		// 0 on timeout.
+		template<typename callback_t>
+		size_t poll(int timeout_ms, callback_t &&callback) {
+			tpacket_block_desc *const block = reinterpret_cast<tpacket_block_desc*>(ring + static_cast<size_t>(current) * block_size);
+			if(!user_owned(block)) {
+				pollfd pfd{sockfd, POLLIN | POLLERR, 0};
+				if(::poll(&pfd, 1, timeout_ms) <= 0 || !user_owned(block)) return 0;
+			}
+
+			uint32_t const count = block->hdr.bh1.num_pkts;
+			uint8_t const *cursor = reinterpret_cast<uint8_t const*>(block) + block->hdr.bh1.offset_to_first_pkt;
+			for(uint32_t i = 0; i < count; ++i) {
+				tpacket3_hdr const *const header = reinterpret_cast<tpacket3_hdr const*>(cursor);
+				sockaddr_ll const *const link = reinterpret_cast<sockaddr_ll const*>(cursor + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+				captured_packet const packet{
+				  std::span<uint8_t const>(cursor + header->tp_mac, header->tp_snaplen),
+				  header->tp_len,
+				  header->tp_sec,
+				  header->tp_nsec,
+				  header->hv1.tp_rxhash,
+				  link->sll_ifindex,
+				  link->sll_pkttype,
+				};
+				callback(packet);
+				cursor += header->tp_next_offset;
+			}
+
+			__atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+			current = (current + 1) % block_count;
+			return count;
+		}
+
+		// Packets received and dropped (ring full) since the last call; reading resets the kernel's counters.
+		[[nodiscard]] tpacket_stats_v3 stats() const {
+			tpacket_stats_v3 result{};
+			socklen_t len = sizeof(result);
+			::getsockopt(sockfd, SOL_PACKET, PACKET_STATISTICS, &result, &len);
+			return result;
+		}
+
+	private:
+		uint32_t const block_size;
+		uint32_t const block_count;
+		uint8_t *ring = nullptr;
+		uint32_t current = 0;
+
+		[[nodiscard]] size_t map_size() const { return static_cast<size_t>(block_size) * block_count; }
+
+		[[nodiscard]] static bool user_owned(tpacket_block_desc *block) {
+			return __atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER;
+		}
+
+		void setup(int result, char const *step) {
+			if(result == 0) return;
+			int const error = errno;
+			if constexpr(debug_mode) {
+				::fprintf(stderr, "Failed to set up packet ring at %s: errno = %d\n", step, error);
+			}
+			// ~packet_ring does not run for a throwing constructor; socket_base still closes the socket.
+			if(ring) ::munmap(ring, map_size());
+			throw packet_ring_setup_failure_exception(step, error);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef OFCT_NETWORK_socket_reuseport_group_hpp
+#define OFCT_NETWORK_socket_reuseport_group_hpp
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "../debug/debug_mode.hpp"
+#include "../exceptions/socket_exceptions.hpp"
+#include "../exceptions/tcp_exceptions.hpp"
+
+namespace OFCT::networking {
+
+	// One SO_REUSEPORT listening socket per worker CPU on the same address. A classic BPF program attached to
+	// the group picks the socket by the CPU that processed the incoming SYN, so a connection is accepted by the
+	// worker pinned to the core (and NUMA node) where its packets already arrive. Sockets are handed to the
+	// workers with release(), e.g. as tcp_server(handler, inherit_socket, group.release(i)).
+	//
+	// If the program cannot be attached (older kernels, seccomp), the kernel's hash over the group is used
+	// and is_steered() reports false; connections still spread over all workers.
+	class reuseport_group {
+	public:
+		// port and ip in host byte order, as for tcp_socket.
+		explicit reuseport_group(in_port_t port, in_addr_t ip, std::vector<int> const &cpus, int backlog = std::numeric_limits<int>::max()) {
+			open(port, ::htonl(ip), cpus, backlog);
+		}
+
+		explicit reuseport_group(in_port_t port, std::string_view ip_str, std::vector<int> const &cpus, int backlog = std::numeric_limits<int>::max()) {
+			in_addr_t const ip = inet_addr(ip_str.data());
+			if(ip == INADDR_NONE) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to parse IP address: %s\n", ip_str.data());
+				}
+				throw tcp_inappropriate_ip_exception(ip);
+			}
+			open(port, ip, cpus, backlog);
+		}
+
+		reuseport_group(reuseport_group const &) = delete;
+		reuseport_group &operator=(reuseport_group const &) = delete;
+
+		~reuseport_group() {
+			close_all();
+		}
+
+		[[nodiscard]] size_t size() const { return sockfds.size(); }
+		[[nodiscard]] int cpu_of(size_t index) const { return cpus[index]; }
+		[[nodiscard]] bool is_steered() const { return steered; }
+
+		// Transfers ownership of the index-th listening socket to the caller. Its position in the group, and
+		// so the connections steered to it, stays the same.
+		[[nodiscard]] int release(size_t index) {
+			int const sockfd = sockfds[index];
+			sockfds[index] = -1;
+			return sockfd;
+		}
+
+	private:
+		std::vector<int> sockfds;
+		std::vector<int> cpus;
+		bool steered = false;
+
+		void open(in_port_t port, in_addr_t ip_network_order, std::vector<int> const &worker_cpus, int backlog) {
+			sockaddr_in addr{};
+			addr.sin_family = AF_INET;
+			addr.sin_port = ::htons(port);
+			addr.sin_addr.s_addr = ip_network_order;
+
+			cpus = worker_cpus;
+			int const one = 1;
+			// The kernel numbers group members in the order they start listening; the program relies on it.
+			for(int cpu : cpus) {
+				int const sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+				if(sockfd == -1) {
+					close_all();
+					throw socket_generation_failed_exception();
+				}
+				sockfds.push_back(sockfd);
+				if(::setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) == -1
+				   || ::bind(sockfd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) == -1) {
+					if constexpr(debug_mode) {
+						::fprintf(stderr, "Failed to bind; port = %hu, ip = %u\n", addr.sin_port, addr.sin_addr.s_addr);
+					}
+					close_all();
+					throw tcp_bind_failure_exception(addr.sin_port, addr.sin_addr.s_addr);
+				}
+				// Also steers without the program: the kernel prefers a member whose incoming CPU matches.
+				(void) ::setsockopt(sockfd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu));
+				if(::listen(sockfd, backlog) == -1) {
+					if constexpr(debug_mode) {
+						::fprintf(stderr, "Failed to listen; port = %hu, ip = %u\n", addr.sin_port, addr.sin_addr.s_addr);
+					}
+					close_all();
+					throw tcp_listen_failure_exception(addr.sin_port, addr.sin_addr.s_addr);
+				}
+			}
+			if(!sockfds.empty()) steered = attach_program();
+		}
+
+		// cpu == cpus[i] selects socket i; any other CPU (e.g. one without a worker) falls back to cpu % size.
+		[[nodiscard]] bool attach_program() {
+			std::vector<sock_filter> program;
+			program.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)));
+			for(size_t i = 0; i < cpus.size(); ++i) {
+				program.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(cpus[i]), 0, 1));
+				program.push_back(BPF_STMT(BPF_RET | BPF_K, static_cast<uint32_t>(i)));
+			}
+			program.push_back(BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<uint32_t>(cpus.size())));
+			program.push_back(BPF_STMT(BPF_RET | BPF_A, 0));
+
+			sock_fprog const fprog{static_cast<unsigned short>(program.size()), program.data()};
+			// Attaching to any one member applies to the whole group.
+			if(::setsockopt(sockfds.front(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &fprog, sizeof(fprog)) == -1) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to attach reuseport program: errno = %d\n", errno);
+				}
+				return false;
+			}
+			return true;
+		}
+
+		void close_all() {
+			for(int &sockfd : sockfds) {
+				if(sockfd != -1) ::close(sockfd);
+				sockfd = -1;
+			}
+		}
+	};
+}
+
+#endif
@@ -217,6 +217,7 @@ namespace OFCT::networking {
 		}
 
         [[nodiscard]] bool is_valid() const { return sockfd != -1; }
+        [[nodiscard]] int native_handle() const { return sockfd; }
 
 	protected:
 		int sockfd;
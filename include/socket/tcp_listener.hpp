@@ -1,26 +1,38 @@
 #ifndef SERVER_TCP_LISTENER_HPP
 #define SERVER_TCP_LISTENER_HPP
 
+#include <poll.h>
+#include <sys/eventfd.h>
+
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <limits>
+#include <mutex>
 #include <thread>
+#include <vector>
 
+#include "admission_control.hpp"
 #include "tcp_socket.hpp"
 #include "tcp_transceiver.hpp"
 
 namespace OFCT::networking {
 
-	// !!VIRTUAL FUNCTION!!
-	template<sockaddr_type type, bool nonblocking>
-	class tcp_listener;
+	struct inherit_socket_t { explicit inherit_socket_t() = default; };
+	constexpr inherit_socket_t inherit_socket{};
+
+	// Accept loop shared by tcp_listener (virtual transceive) and tcp_server (handler inlined into the loop);
+	// each accepted connection is passed to derived::dispatch.
+	template<sockaddr_type type, bool nonblocking, typename derived>
+	class basic_tcp_listener;
 
 	// IPv4 blocking: single thread, operates one at a time
-	template<>
-	class tcp_listener<sockaddr_type_in, false> : public tcp_socket<sockaddr_type_in, false> {
+	template<typename derived>
+	class basic_tcp_listener<sockaddr_type_in, false, derived> : public tcp_socket<sockaddr_type_in, false> {
 	protected:
 		using socktype = tcp_socket<sockaddr_type_in, false>::socktype;
 	public:
-		explicit tcp_listener(int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, false>() {
+		explicit basic_tcp_listener(int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, false>() {
 			if(!bind()) {
 				if constexpr(debug_mode) {
 					::fprintf(stderr, "Failed to bind; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
@@ -28,7 +40,7 @@ namespace OFCT::networking {
 				throw tcp_bind_failure_exception(this->addr.sin_port, this->addr.sin_addr.s_addr);
 			}
 		}
-		explicit tcp_listener(in_port_t port, in_addr_t ip, int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, false>(port, ip) {
+		explicit basic_tcp_listener(in_port_t port, in_addr_t ip, int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, false>(port, ip) {
 			if(!bind()) {
 				if constexpr(debug_mode) {
 					::fprintf(stderr, "Failed to bind; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
@@ -36,7 +48,7 @@ namespace OFCT::networking {
 				throw tcp_bind_failure_exception(this->addr.sin_port, this->addr.sin_addr.s_addr);
 			}
 		}
-		explicit tcp_listener(in_port_t port, std::string_view ip_str, int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, false>(port, ip_str) {
+		explicit basic_tcp_listener(in_port_t port, std::string_view ip_str, int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, false>(port, ip_str) {
 			if(!bind()) {
 				if constexpr(debug_mode) {
 					::fprintf(stderr, "Failed to bind; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
@@ -44,9 +56,23 @@ namespace OFCT::networking {
 				throw tcp_bind_failure_exception(this->addr.sin_port, this->addr.sin_addr.s_addr);
 			}
 		}
+		// Takes over an already bound socket, e.g. one received through fd_handoff; no bind is attempted.
+		explicit basic_tcp_listener(inherit_socket_t, int sockfd, int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, false>(sockfd) {}
+
+		~basic_tcp_listener() override {
+			if(wakefd != -1) ::close(wakefd);
+		}
+
+		// Any thread. A loop waiting for connections rechecks flag_quit right away instead of after up to
+		// ACCEPT_WAIT_MS; set flag_quit first.
+		void wake() const {
+			uint64_t const one = 1;
+			[[maybe_unused]] ssize_t const written = ::write(wakefd, &one, sizeof(one));
+		}
 
 		void loop(std::atomic_bool const &flag_quit) {
-			while(!flag_quit.load(std::memory_order_seq_cst)) {
+			set_accept_nonblocking();
+			while(!flag_quit.load(std::memory_order_acquire)) {
 				if(!listen()) {
 					if constexpr(debug_mode) {
 						::fprintf(stderr, "Failed to listen; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
@@ -55,8 +81,9 @@ namespace OFCT::networking {
 				}
 
 				socktype peer_addr;
-				int peer_sockfd = accept(peer_addr);
+				int peer_sockfd = accept_or_wait(peer_addr);
 				if(peer_sockfd == -1) {
+					if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED) continue;
 					if constexpr(debug_mode) {
 						::fprintf(stderr, "Failed to accept; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
 					}
@@ -64,7 +91,8 @@ namespace OFCT::networking {
 				}
 
 				tcp_transceiver<sockaddr_type_in, false> transceiver(peer_sockfd, peer_addr.sin_port, peer_addr.sin_addr.s_addr);
-				if(!transceive(flag_quit, transceiver)) {
+				transceiver.attach_tap(tap.load(std::memory_order_acquire));
+				if(!serve(flag_quit, transceiver)) {
 					if constexpr(debug_mode) {
 						::fprintf(stderr, "Failed while transceiving.\n");
 					}
@@ -73,11 +101,139 @@ namespace OFCT::networking {
 			}
 		}
 
-	protected:
-		virtual bool transceive(std::atomic_bool const &flag_quit, tcp_transceiver<sockaddr_type_in, false> const &transceiver) = 0;
+		// Accepts on this thread and serves from admission's worker threads. Connections over the caps or rate
+		// limits, or beyond max_queued waiting for a worker, are rejected as soon as they are accepted, and ones
+		// that queued too long are shed on dequeue, so under overload the excess is turned away quickly instead
+		// of delaying everyone. max_in_flight is not enforced here; handlers opt in with a request_slot.
+		// As with the loop above, a handler failure ends the loop with tcp_transceive_failure_exception, once the
+		// workers have stopped and the connections still queued have been rejected.
+		void loop(std::atomic_bool const &flag_quit, admission_control &admission) {
+			if(!listen()) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to listen; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
+				}
+				throw tcp_listen_failure_exception(this->addr.sin_port, this->addr.sin_addr.s_addr);
+			}
+			set_accept_nonblocking();
+
+			struct pending_connection {
+				int sockfd;
+				socktype peer_addr;
+				admission_control::clock::time_point accepted_at;
+			};
+			std::mutex queue_mutex;
+			std::condition_variable queue_ready;
+			std::deque<pending_connection> queue;
+			bool stopping = false;
+			std::atomic_bool transceive_failed = false;
+			size_t const max_queued = std::max<size_t>(admission.get_limits().max_queued, 1);
+
+			auto work = [&]() {
+				while(true) {
+					std::unique_lock<std::mutex> lock(queue_mutex);
+					queue_ready.wait(lock, [&]() { return stopping || !queue.empty(); });
+					if(queue.empty()) return;
+					pending_connection const connection = queue.front();
+					queue.pop_front();
+					auto const now = admission_control::clock::now();
+					bool const shed = stopping || admission.should_shed(now - connection.accepted_at, now);
+					lock.unlock();
+
+					if(shed) admission.reject(connection.sockfd);
+					else {
+						tcp_transceiver<sockaddr_type_in, false> transceiver(connection.sockfd, connection.peer_addr.sin_port, connection.peer_addr.sin_addr.s_addr);
+						transceiver.attach_tap(tap.load(std::memory_order_acquire));
+						if(!serve(flag_quit, transceiver) && !transceive_failed.exchange(true, std::memory_order_acq_rel)) {
+							if constexpr(debug_mode) {
+								::fprintf(stderr, "Failed while transceiving.\n");
+							}
+							wake();
+						}
+					}
+					admission.release_connection();
+				}
+			};
+			std::vector<std::thread> workers;
+			for(size_t i = 0; i < std::max<size_t>(admission.get_limits().workers, 1); ++i) workers.emplace_back(work);
+
+			bool failed = false;
+			while(!flag_quit.load(std::memory_order_acquire) && !transceive_failed.load(std::memory_order_acquire)) {
+				socktype peer_addr;
+				int peer_sockfd = accept_or_wait(peer_addr);
+				if(peer_sockfd == -1) {
+					if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED) continue;
+					failed = true;
+					break;
+				}
+
+				auto const now = admission_control::clock::now();
+				if(!admission.admit(peer_addr.sin_addr.s_addr, now)) {
+					admission.reject(peer_sockfd);
+					continue;
+				}
+				bool queued = false;
+				{
+					std::lock_guard<std::mutex> lock(queue_mutex);
+					if(queue.size() < max_queued) {
+						queue.push_back(pending_connection{peer_sockfd, peer_addr, now});
+						queued = true;
+					}
+				}
+				if(queued) queue_ready.notify_one();
+				else admission.reject_unqueued(peer_sockfd);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(queue_mutex);
+				stopping = true;
+			}
+			queue_ready.notify_all();
+			for(std::thread &worker : workers) worker.join();
+
+			if(failed) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to accept; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
+				}
+				throw tcp_accept_failure_exception(this->addr.sin_port, this->addr.sin_addr.s_addr);
+			}
+			if(transceive_failed.load(std::memory_order_acquire)) throw tcp_transceive_failure_exception();
+		}
+
+		// Every connection accepted from now on is offered to tap (nullptr: none); the tap has to outlive the listener.
+		void set_tap(traffic_tap *tap) { this->tap.store(tap, std::memory_order_release); }
+
+		// Handles one accepted connection with the derived class's handler.
+		[[nodiscard]] bool serve(std::atomic_bool const &flag_quit, tcp_transceiver<sockaddr_type_in, false> const &transceiver) {
+			return static_cast<derived*>(this)->dispatch(flag_quit, transceiver);
+		}
 
 	private:
+		static constexpr int ACCEPT_WAIT_MS = 100;
+
 		int backlog;
+		std::atomic<traffic_tap*> tap = nullptr;
+		int wakefd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+		// Accepts without blocking; with nothing queued, waits up to ACCEPT_WAIT_MS for a connection or wake() and
+		// fails with EAGAIN, so the caller's loop rechecks flag_quit instead of spinning on accept.
+		[[nodiscard]] int accept_or_wait(socktype &peer_addr) const {
+			int const peer_sockfd = accept(peer_addr);
+			if(peer_sockfd != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) return peer_sockfd;
+			pollfd ready[2]{{this->sockfd, POLLIN, 0}, {wakefd, POLLIN, 0}};
+			if(::poll(ready, 2, ACCEPT_WAIT_MS) > 0 && (ready[1].revents & POLLIN)) {
+				uint64_t value;
+				[[maybe_unused]] ssize_t const drained = ::read(wakefd, &value, sizeof(value));
+			}
+			errno = EAGAIN;
+			return -1;
+		}
+
+		// The listening socket only: Linux does not pass O_NONBLOCK on to accepted sockets, so transceivers are
+		// unaffected. accept_or_wait() relies on it to never block in accept.
+		void set_accept_nonblocking() const {
+			::fcntl(this->sockfd, F_SETFL, ::fcntl(this->sockfd, F_GETFL, 0) | O_NONBLOCK);
+		}
+
 		[[nodiscard]] bool bind() const {
 			return !::bind(this->sockfd, reinterpret_cast<sockaddr const*>(&this->addr), sizeof(this->addr));
 		}
@@ -87,7 +243,7 @@ namespace OFCT::networking {
 		}
 
 		[[nodiscard]] int accept(socktype &peer_addr) const {
-			socklen_t peer_addrlen;
+			socklen_t peer_addrlen = sizeof(peer_addr);
 			return ::accept(this->sockfd, reinterpret_cast<sockaddr*>(&peer_addr), &peer_addrlen);
 		}
 
@@ -97,12 +253,12 @@ namespace OFCT::networking {
 	};
 
 	// IPv4 nonblocking
-	template<>
-	class tcp_listener<sockaddr_type_in, true> : public tcp_socket<sockaddr_type_in, true> {
+	template<typename derived>
+	class basic_tcp_listener<sockaddr_type_in, true, derived> : public tcp_socket<sockaddr_type_in, true> {
 	protected:
 		using socktype = tcp_socket<sockaddr_type_in, true>::socktype;
 	public:
-		explicit tcp_listener(int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, true>() {
+		explicit basic_tcp_listener(int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, true>() {
 			if(!bind()) {
 				if constexpr(debug_mode) {
 					::fprintf(stderr, "Failed to bind; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
@@ -110,7 +266,7 @@ namespace OFCT::networking {
 				throw tcp_bind_failure_exception(this->addr.sin_port, this->addr.sin_addr.s_addr);
 			}
 		}
-		explicit tcp_listener(in_port_t port, in_addr_t ip, int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, true>(port, ip) {
+		explicit basic_tcp_listener(in_port_t port, in_addr_t ip, int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, true>(port, ip) {
 			if(!bind()) {
 				if constexpr(debug_mode) {
 					::fprintf(stderr, "Failed to bind; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
@@ -118,7 +274,7 @@ namespace OFCT::networking {
 				throw tcp_bind_failure_exception(this->addr.sin_port, this->addr.sin_addr.s_addr);
 			}
 		}
-		explicit tcp_listener(in_port_t port, std::string_view ip_str, int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, true>(port, ip_str) {
+		explicit basic_tcp_listener(in_port_t port, std::string_view ip_str, int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, true>(port, ip_str) {
 			if(!bind()) {
 				if constexpr(debug_mode) {
 					::fprintf(stderr, "Failed to bind; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
@@ -126,9 +282,22 @@ namespace OFCT::networking {
 				throw tcp_bind_failure_exception(this->addr.sin_port, this->addr.sin_addr.s_addr);
 			}
 		}
+		// Takes over an already bound socket, e.g. one received through fd_handoff; no bind is attempted.
+		explicit basic_tcp_listener(inherit_socket_t, int sockfd, int backlog = std::numeric_limits<int>::max()) : backlog(backlog), tcp_socket<sockaddr_type_in, true>(sockfd) {}
+
+		~basic_tcp_listener() override {
+			if(wakefd != -1) ::close(wakefd);
+		}
+
+		// Any thread. A loop waiting for connections rechecks flag_quit right away instead of after up to
+		// ACCEPT_WAIT_MS; set flag_quit first.
+		void wake() const {
+			uint64_t const one = 1;
+			[[maybe_unused]] ssize_t const written = ::write(wakefd, &one, sizeof(one));
+		}
 
 		void loop(std::atomic_bool const &flag_quit) {
-			while(!flag_quit.load(std::memory_order_seq_cst)) {
+			while(!flag_quit.load(std::memory_order_acquire)) {
 				if(!listen()) {
 					if constexpr(debug_mode) {
 						::fprintf(stderr, "Failed to listen; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
@@ -151,7 +320,8 @@ namespace OFCT::networking {
 				// TODO: Fix [&].
 				std::thread t([&]() {
 					tcp_transceiver<sockaddr_type_in, true> transceiver(peer_sockfd, peer_addr.sin_port, peer_addr.sin_addr.s_addr);
-					if(!transceive(flag_quit, transceiver)) {
+					transceiver.attach_tap(tap.load(std::memory_order_acquire));
+					if(!serve(flag_quit, transceiver)) {
 						if constexpr(debug_mode) {
 							::fprintf(stderr, "Failed while transceiving.\n");
 						}
@@ -162,11 +332,84 @@ namespace OFCT::networking {
 			}
 		}
 
-	protected:
-		virtual bool transceive(std::atomic_bool const &flag_quit, tcp_transceiver<sockaddr_type_in, true> const &transceiver) = 0;
+		// Thread per connection as above, with admission's caps and rate limits applied at accept. There is no
+		// queue here, so queue-delay shedding and max_queued do not apply, and max_in_flight is left to handlers
+		// that take a request_slot. The connection threads are detached, so unlike the loop above a handler
+		// failure is only logged and ends that connection alone.
+		void loop(std::atomic_bool const &flag_quit, admission_control &admission) {
+			if(!listen()) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to listen; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
+				}
+				throw tcp_listen_failure_exception(this->addr.sin_port, this->addr.sin_addr.s_addr);
+			}
+			set_accept_nonblocking();
+
+			while(!flag_quit.load(std::memory_order_acquire)) {
+				socktype peer_addr;
+				int peer_sockfd = accept_or_wait(peer_addr);
+				if(peer_sockfd == -1) {
+					if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED) continue;
+					if constexpr(debug_mode) {
+						::fprintf(stderr, "Failed to accept; port = %hu, ip = %u\n", this->addr.sin_port, this->addr.sin_addr.s_addr);
+					}
+					throw tcp_accept_failure_exception(this->addr.sin_port, this->addr.sin_addr.s_addr);
+				}
+
+				if(!admission.admit(peer_addr.sin_addr.s_addr, admission_control::clock::now())) {
+					admission.reject(peer_sockfd);
+					continue;
+				}
+				std::thread([this, &flag_quit, &admission, peer_sockfd, peer_addr]() {
+					{
+						tcp_transceiver<sockaddr_type_in, true> transceiver(peer_sockfd, peer_addr.sin_port, peer_addr.sin_addr.s_addr);
+						transceiver.attach_tap(tap.load(std::memory_order_acquire));
+						if(!serve(flag_quit, transceiver)) {
+							if constexpr(debug_mode) {
+								::fprintf(stderr, "Failed while transceiving.\n");
+							}
+						}
+					}
+					admission.release_connection();
+				}).detach();
+			}
+		}
+
+		// Every connection accepted from now on is offered to tap (nullptr: none); the tap has to outlive the listener.
+		void set_tap(traffic_tap *tap) { this->tap.store(tap, std::memory_order_release); }
+
+		// Handles one accepted connection with the derived class's handler.
+		[[nodiscard]] bool serve(std::atomic_bool const &flag_quit, tcp_transceiver<sockaddr_type_in, true> const &transceiver) {
+			return static_cast<derived*>(this)->dispatch(flag_quit, transceiver);
+		}
 
 	private:
+		static constexpr int ACCEPT_WAIT_MS = 100;
+
 		int backlog;
+		std::atomic<traffic_tap*> tap = nullptr;
+		int wakefd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+		// Accepts without blocking; with nothing queued, waits up to ACCEPT_WAIT_MS for a connection or wake() and
+		// fails with EAGAIN, so the caller's loop rechecks flag_quit instead of spinning on accept.
+		[[nodiscard]] int accept_or_wait(socktype &peer_addr) const {
+			int const peer_sockfd = accept(peer_addr);
+			if(peer_sockfd != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) return peer_sockfd;
+			pollfd ready[2]{{this->sockfd, POLLIN, 0}, {wakefd, POLLIN, 0}};
+			if(::poll(ready, 2, ACCEPT_WAIT_MS) > 0 && (ready[1].revents & POLLIN)) {
+				uint64_t value;
+				[[maybe_unused]] ssize_t const drained = ::read(wakefd, &value, sizeof(value));
+			}
+			errno = EAGAIN;
+			return -1;
+		}
+
+		// The listening socket only: Linux does not pass O_NONBLOCK on to accepted sockets, so transceivers are
+		// unaffected. accept_or_wait() relies on it to never block in accept.
+		void set_accept_nonblocking() const {
+			::fcntl(this->sockfd, F_SETFL, ::fcntl(this->sockfd, F_GETFL, 0) | O_NONBLOCK);
+		}
+
 		[[nodiscard]] bool bind() const {
 			return !::bind(this->sockfd, reinterpret_cast<sockaddr const*>(&this->addr), sizeof(this->addr));
 		}
@@ -176,7 +419,7 @@ namespace OFCT::networking {
 		}
 
 		[[nodiscard]] int accept(socktype &peer_addr) const {
-			socklen_t peer_addrlen;
+			socklen_t peer_addrlen = sizeof(peer_addr);
 			return ::accept(this->sockfd, reinterpret_cast<sockaddr*>(&peer_addr), &peer_addrlen);
 		}
 
@@ -184,6 +427,23 @@ namespace OFCT::networking {
 			return ::accept(this->sockfd, reinterpret_cast<sockaddr*>(&peer_addr), &peer_addrlen);
 		}
 	};
+
+	// !!VIRTUAL FUNCTION!!
+	template<sockaddr_type type, bool nonblocking>
+	class tcp_listener : public basic_tcp_listener<type, nonblocking, tcp_listener<type, nonblocking>> {
+		friend basic_tcp_listener<type, nonblocking, tcp_listener<type, nonblocking>>;
+
+	public:
+		using basic_tcp_listener<type, nonblocking, tcp_listener<type, nonblocking>>::basic_tcp_listener;
+
+	protected:
+		virtual bool transceive(std::atomic_bool const &flag_quit, tcp_transceiver<type, nonblocking> const &transceiver) = 0;
+
+	private:
+		bool dispatch(std::atomic_bool const &flag_quit, tcp_transceiver<type, nonblocking> const &transceiver) {
+			return transceive(flag_quit, transceiver);
+		}
+	};
 }
 
 #endif
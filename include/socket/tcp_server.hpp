@@ -0,0 +1,42 @@
+#ifndef OFCT_NETWORK_socket_tcp_server_hpp
+#define OFCT_NETWORK_socket_tcp_server_hpp
+
+#include <concepts>
+#include <utility>
+
+#include "tcp_listener.hpp"
+
+namespace OFCT::networking {
+
+	template<typename handler_t, sockaddr_type type, bool nonblocking>
+	concept tcp_handler = requires(handler_t &handler, std::atomic_bool const &flag_quit, tcp_transceiver<type, nonblocking> const &transceiver) {
+		{ handler.transceive(flag_quit, transceiver) } -> std::convertible_to<bool>;
+	};
+
+	// Listener instantiated with its protocol handler: transceive is called on the concrete handler type,
+	// so it can be inlined into the accept loop instead of going through tcp_listener's vtable.
+	template<sockaddr_type type, bool nonblocking, typename handler_t>
+	requires tcp_handler<handler_t, type, nonblocking>
+	class tcp_server : public basic_tcp_listener<type, nonblocking, tcp_server<type, nonblocking, handler_t>> {
+		friend basic_tcp_listener<type, nonblocking, tcp_server<type, nonblocking, handler_t>>;
+
+	public:
+		// Remaining arguments are those of tcp_listener: ([port, ip,] [backlog]) or (inherit_socket, sockfd[, backlog]).
+		template<typename... listener_args>
+		explicit tcp_server(handler_t handler, listener_args &&...args)
+		  : basic_tcp_listener<type, nonblocking, tcp_server<type, nonblocking, handler_t>>(std::forward<listener_args>(args)...),
+		    handler(std::move(handler)) {}
+
+		[[nodiscard]] handler_t &get_handler() { return handler; }
+		[[nodiscard]] handler_t const &get_handler() const { return handler; }
+
+	private:
+		handler_t handler;
+
+		bool dispatch(std::atomic_bool const &flag_quit, tcp_transceiver<type, nonblocking> const &transceiver) {
+			return handler.transceive(flag_quit, transceiver);
+		}
+	};
+}
+
+#endif
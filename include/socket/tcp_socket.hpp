@@ -100,8 +100,36 @@ namespace OFCT::networking {
 		    ::memset(addr.sin_zero, 0, sizeof(addr.sin_zero));
 		}
 
+		// Adopts an already listening socket, e.g. one inherited from a previous process; addr is read back from it.
+		// The socket is checked before it is adopted, so on tcp_inherited_socket_invalid_exception the caller
+		// still owns sockfd.
+		explicit tcp_socket(int sockfd)
+		  : socket_base<domain_inet, type_stream, protocol_default, false>(validate_inherited(sockfd)) {
+			socklen_t addrlen = sizeof(addr);
+			(void) ::getsockname(sockfd, reinterpret_cast<sockaddr*>(&addr), &addrlen);
+		}
+
 	protected:
 		socktype addr;
+
+	private:
+		[[nodiscard]] static int validate_inherited(int sockfd) {
+			socktype local{};
+			socklen_t addrlen = sizeof(local);
+			int socket_type = 0;
+			int accepting = 0;
+			socklen_t optlen = sizeof(int);
+			bool const valid = ::getsockname(sockfd, reinterpret_cast<sockaddr*>(&local), &addrlen) != -1 && local.sin_family == family
+			                   && ::getsockopt(sockfd, SOL_SOCKET, SO_TYPE, &socket_type, &optlen) != -1 && socket_type == SOCK_STREAM
+			                   && ::getsockopt(sockfd, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &optlen) != -1 && accepting == 1;
+			if(!valid) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Inherited socket %d is not a listening IPv4 TCP socket.\n", sockfd);
+				}
+				throw tcp_inherited_socket_invalid_exception(sockfd);
+			}
+			return sockfd;
+		}
 	};
 }
 
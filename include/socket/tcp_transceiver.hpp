@@ -2,7 +2,14 @@
 #define SERVER_TCP_TRANSCEIVER_HPP
 
 #include "tcp_socket.hpp"
+#include "../tap/traffic_tap.hpp"
 
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <climits>
 #include <vector>
 
 namespace OFCT::networking {
@@ -31,12 +38,31 @@ namespace OFCT::networking {
 		explicit tcp_transceiver(int sockfd, in_port_t port, std::string_view ip_str)
 		  : tcp_socket<sockaddr_type_in, false>(sockfd, port, ip_str) {}
 
+		~tcp_transceiver() {
+			if(tap) tap->record(tap_connection, tap_close, nullptr, 0);
+		}
+
+		// Records this connection's traffic from now on, if the tap samples it. The tap has to outlive the transceiver.
+		void attach_tap(traffic_tap *tap) {
+			if(!tap || this->tap) return;
+			sockaddr_in peer{};
+			socklen_t peer_len = sizeof(peer);
+			(void) ::getpeername(this->sockfd, reinterpret_cast<sockaddr*>(&peer), &peer_len);
+			tap_connection = tap->open(peer.sin_addr.s_addr, peer.sin_port);
+			if(tap_connection) this->tap = tap;
+		}
+
+		// send, recv and sendv all end up in send_raw, recv_raw and sendv_raw, which feed the tap; send_file's bytes are not recorded.
 		[[nodiscard]] ssize_t send_raw(void const *buf, size_t len, int flags = 0) const {
-			return ::send(this->sockfd, buf, len, flags);
+			ssize_t const sent = ::send(this->sockfd, buf, len, flags);
+			if(tap && sent > 0) tap->record(tap_connection, tap_send, buf, static_cast<size_t>(sent));
+			return sent;
 		}
 
 		[[nodiscard]] ssize_t recv_raw(void *buf, size_t len, int flags = 0) const {
-			return ::recv(this->sockfd, buf, len, flags);
+			ssize_t const received = ::recv(this->sockfd, buf, len, flags);
+			if(tap && received >= 0 && !(flags & MSG_PEEK) && (received || len)) tap->record(tap_connection, received ? tap_recv : tap_peer_close, buf, static_cast<size_t>(received));
+			return received;
 		}
 
 		[[nodiscard]] bool send(void const *buf, size_t len) const {
@@ -63,6 +89,49 @@ namespace OFCT::networking {
 			return send(buf.data(), buf.size());
 		}
 
+		[[nodiscard]] ssize_t sendv_raw(iovec const *iov, int iovcnt, int flags = 0) const {
+			msghdr msg{};
+			msg.msg_iov = const_cast<iovec*>(iov);
+			msg.msg_iovlen = static_cast<size_t>(iovcnt);
+			ssize_t const sent = ::sendmsg(this->sockfd, &msg, flags);
+			if(tap && sent > 0) tap->record(tap_connection, tap_send, iov, iovcnt, static_cast<size_t>(sent));
+			return sent;
+		}
+
+		// Gathers the buffers into as few syscalls as the kernel allows; iov is consumed as it is sent.
+		[[nodiscard]] bool sendv(iovec *iov, int iovcnt) const {
+			while(iovcnt > 0) {
+				ssize_t sent = sendv_raw(iov, std::min(iovcnt, IOV_MAX));
+				if(sent == -1) {
+					if constexpr(debug_mode) {
+						::fprintf(stderr, "Failed to send.\n");
+					}
+					return false;
+				}
+				for(; iovcnt > 0 && static_cast<size_t>(sent) >= iov->iov_len; ++iov, --iovcnt) sent -= static_cast<ssize_t>(iov->iov_len);
+				if(iovcnt > 0) {
+					iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + sent;
+					iov->iov_len -= static_cast<size_t>(sent);
+				}
+			}
+			return true;
+		}
+
+		// Zero-copy path; also stays zero-copy once kTLS is installed on the socket.
+		[[nodiscard]] bool send_file(int fd, off_t offset, size_t len) const {
+			while(len) {
+				ssize_t const sent = ::sendfile(this->sockfd, fd, &offset, len);
+				if(sent <= 0) {
+					if constexpr(debug_mode) {
+						::fprintf(stderr, "Failed to send file.\n");
+					}
+					return false;
+				}
+				len -= sent;
+			}
+			return true;
+		}
+
 		[[nodiscard]] bool recv(void *buf, size_t len) const {
 			size_t offset = 0;
 			while(offset < len) {
@@ -88,6 +157,10 @@ namespace OFCT::networking {
 			buf.resize(len);
 			return recv(buf.data(), len);
 		}
+
+	private:
+		traffic_tap *tap = nullptr;
+		uint32_t tap_connection = 0;
 	};
 
 	// nonblocking
@@ -111,12 +184,31 @@ namespace OFCT::networking {
 		explicit tcp_transceiver(int sockfd, in_port_t port, std::string_view ip_str)
 				: tcp_socket<sockaddr_type_in, true>(sockfd, port, ip_str) {}
 
+		~tcp_transceiver() {
+			if(tap) tap->record(tap_connection, tap_close, nullptr, 0);
+		}
+
+		// Records this connection's traffic from now on, if the tap samples it. The tap has to outlive the transceiver.
+		void attach_tap(traffic_tap *tap) {
+			if(!tap || this->tap) return;
+			sockaddr_in peer{};
+			socklen_t peer_len = sizeof(peer);
+			(void) ::getpeername(this->sockfd, reinterpret_cast<sockaddr*>(&peer), &peer_len);
+			tap_connection = tap->open(peer.sin_addr.s_addr, peer.sin_port);
+			if(tap_connection) this->tap = tap;
+		}
+
+		// send, recv and sendv all end up in send_raw, recv_raw and sendv_raw, which feed the tap; send_file's bytes are not recorded.
 		[[nodiscard]] ssize_t send_raw(void const *buf, size_t len, int flags = 0) const {
-			return ::send(this->sockfd, buf, len, flags);
+			ssize_t const sent = ::send(this->sockfd, buf, len, flags);
+			if(tap && sent > 0) tap->record(tap_connection, tap_send, buf, static_cast<size_t>(sent));
+			return sent;
 		}
 
 		[[nodiscard]] ssize_t recv_raw(void *buf, size_t len, int flags = 0) const {
-			return ::recv(this->sockfd, buf, len, flags);
+			ssize_t const received = ::recv(this->sockfd, buf, len, flags);
+			if(tap && received >= 0 && !(flags & MSG_PEEK) && (received || len)) tap->record(tap_connection, received ? tap_recv : tap_peer_close, buf, static_cast<size_t>(received));
+			return received;
 		}
 
 		[[nodiscard]] bool send(void const *buf, size_t len) const {
@@ -143,6 +235,54 @@ namespace OFCT::networking {
 			return send(buf.data(), buf.size());
 		}
 
+		[[nodiscard]] ssize_t sendv_raw(iovec const *iov, int iovcnt, int flags = 0) const {
+			msghdr msg{};
+			msg.msg_iov = const_cast<iovec*>(iov);
+			msg.msg_iovlen = static_cast<size_t>(iovcnt);
+			ssize_t const sent = ::sendmsg(this->sockfd, &msg, flags);
+			if(tap && sent > 0) tap->record(tap_connection, tap_send, iov, iovcnt, static_cast<size_t>(sent));
+			return sent;
+		}
+
+		[[nodiscard]] bool sendv(iovec *iov, int iovcnt) const {
+			while(iovcnt > 0) {
+				ssize_t sent = sendv_raw(iov, std::min(iovcnt, IOV_MAX));
+				if(sent == -1) {
+					if(errno == EAGAIN || errno == EWOULDBLOCK) continue;
+					if constexpr(debug_mode) {
+						::fprintf(stderr, "Failed to send.\n");
+					}
+					return false;
+				}
+				for(; iovcnt > 0 && static_cast<size_t>(sent) >= iov->iov_len; ++iov, --iovcnt) sent -= static_cast<ssize_t>(iov->iov_len);
+				if(iovcnt > 0) {
+					iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + sent;
+					iov->iov_len -= static_cast<size_t>(sent);
+				}
+			}
+			return true;
+		}
+
+		[[nodiscard]] bool send_file(int fd, off_t offset, size_t len) const {
+			while(len) {
+				ssize_t const sent = ::sendfile(this->sockfd, fd, &offset, len);
+				if(sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+					// Sleep until the send buffer drains instead of spinning on sendfile().
+					pollfd writable{this->sockfd, POLLOUT, 0};
+					if(::poll(&writable, 1, -1) == -1 && errno != EINTR) return false;
+					continue;
+				}
+				if(sent <= 0) {
+					if constexpr(debug_mode) {
+						::fprintf(stderr, "Failed to send file.\n");
+					}
+					return false;
+				}
+				len -= sent;
+			}
+			return true;
+		}
+
 		[[nodiscard]] bool recv(void *buf, size_t len) const {
 			size_t offset = 0;
 			while(offset < len) {
@@ -168,6 +308,10 @@ namespace OFCT::networking {
 			buf.resize(len);
 			return recv(buf.data(), len);
 		}
+
+	private:
+		traffic_tap *tap = nullptr;
+		uint32_t tap_connection = 0;
 	};
 
 }
@@ -0,0 +1,153 @@
+#ifndef OFCT_NETWORK_socket_tls_transceiver_hpp
+#define OFCT_NETWORK_socket_tls_transceiver_hpp
+
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+#include <openssl/kdf.h>
+
+#include "tcp_transceiver.hpp"
+#include "../tls/tls_context.hpp"
+
+namespace OFCT::networking {
+
+	namespace ktls_detail {
+		// RFC 8446 7.1: HKDF-Expand-Label(secret, label, "", len)
+		[[nodiscard]] inline bool hkdf_expand_label(EVP_MD const *md, uint8_t const *secret, size_t secret_len,
+		                                            std::string_view label, uint8_t *out, size_t out_len) {
+			uint8_t info[2 + 1 + 6 + 16 + 1];
+			size_t info_len = 0;
+			info[info_len++] = static_cast<uint8_t>(out_len >> 8);
+			info[info_len++] = static_cast<uint8_t>(out_len);
+			info[info_len++] = static_cast<uint8_t>(6 + label.size());
+			::memcpy(info + info_len, "tls13 ", 6);
+			info_len += 6;
+			::memcpy(info + info_len, label.data(), label.size());
+			info_len += label.size();
+			info[info_len++] = 0;
+
+			EVP_PKEY_CTX *pctx = ::EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
+			if(pctx == nullptr) return false;
+			bool const result = ::EVP_PKEY_derive_init(pctx) > 0
+			    && ::EVP_PKEY_CTX_hkdf_mode(pctx, EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) > 0
+			    && ::EVP_PKEY_CTX_set_hkdf_md(pctx, md) > 0
+			    && ::EVP_PKEY_CTX_set1_hkdf_key(pctx, secret, static_cast<int>(secret_len)) > 0
+			    && ::EVP_PKEY_CTX_add1_hkdf_info(pctx, info, static_cast<int>(info_len)) > 0
+			    && ::EVP_PKEY_derive(pctx, out, &out_len) > 0;
+			::EVP_PKEY_CTX_free(pctx);
+			return result;
+		}
+
+		// The kernel takes the 12-byte TLS 1.3 IV split as salt || iv; the record sequence starts at zero.
+		template<typename crypto_info_t>
+		[[nodiscard]] bool install(int sockfd, int direction, uint16_t cipher_type, EVP_MD const *md,
+		                           uint8_t const *secret, size_t secret_len) {
+			crypto_info_t crypto_info{};
+			uint8_t iv[12];
+			if(!hkdf_expand_label(md, secret, secret_len, "key", crypto_info.key, sizeof(crypto_info.key))) return false;
+			if(!hkdf_expand_label(md, secret, secret_len, "iv", iv, sizeof(iv))) return false;
+			static_assert(sizeof(crypto_info.salt) + sizeof(crypto_info.iv) == sizeof(iv));
+			crypto_info.info.version = TLS_1_3_VERSION;
+			crypto_info.info.cipher_type = cipher_type;
+			::memcpy(crypto_info.salt, iv, sizeof(crypto_info.salt));
+			::memcpy(crypto_info.iv, iv + sizeof(crypto_info.salt), sizeof(crypto_info.iv));
+			bool const result = !::setsockopt(sockfd, SOL_TLS, direction, &crypto_info, sizeof(crypto_info));
+			::OPENSSL_cleanse(&crypto_info, sizeof(crypto_info));
+			::OPENSSL_cleanse(iv, sizeof(iv));
+			return result;
+		}
+
+		[[nodiscard]] inline bool install(int sockfd, int direction, SSL_CIPHER const *cipher,
+		                                  uint8_t const *secret, size_t secret_len) {
+			EVP_MD const *md = ::SSL_CIPHER_get_handshake_digest(cipher);
+			switch(::SSL_CIPHER_get_protocol_id(cipher)) {
+			case 0x1301: return install<tls12_crypto_info_aes_gcm_128>(sockfd, direction, TLS_CIPHER_AES_GCM_128, md, secret, secret_len);
+			case 0x1302: return install<tls12_crypto_info_aes_gcm_256>(sockfd, direction, TLS_CIPHER_AES_GCM_256, md, secret, secret_len);
+			case 0x1303: return install<tls12_crypto_info_chacha20_poly1305>(sockfd, direction, TLS_CIPHER_CHACHA20_POLY1305, md, secret, secret_len);
+			default: return false;
+			}
+		}
+	}
+
+	// Performs the TLS 1.3 handshake on a connected socket in user space, then installs the traffic keys with
+	// setsockopt(SOL_TLS) so plain send/recv/sendfile on the socket are encrypted by the kernel afterwards.
+	// Works on any connected TCP socket, e.g. ktls_handshake(ctx, transceiver.native_handle()) inside transceive().
+	[[nodiscard]] inline bool ktls_handshake(tls_context const &ctx, int sockfd) {
+		SSL *ssl = ::SSL_new(ctx.native_handle());
+		if(ssl == nullptr) return false;
+
+		tls_traffic_secrets secrets;
+		SSL_set_app_data(ssl, &secrets);
+		::SSL_set_fd(ssl, sockfd);
+
+		int ret;
+		while(true) {
+			ret = ctx.get_role() == tls_role_server ? ::SSL_accept(ssl) : ::SSL_connect(ssl);
+			if(ret == 1) break;
+			int const error = ::SSL_get_error(ssl, ret);
+			if(error != SSL_ERROR_WANT_READ && error != SSL_ERROR_WANT_WRITE) break;
+			// Only a nonblocking socket gets here; wait for the direction OpenSSL needs instead of spinning.
+			pollfd ready{sockfd, static_cast<short>(error == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT), 0};
+			if(::poll(&ready, 1, -1) == -1 && errno != EINTR) break;
+		}
+
+		bool result = false;
+		if(ret != 1) {
+			if constexpr(debug_mode) {
+				char reason[256];
+				::ERR_error_string_n(::ERR_get_error(), reason, sizeof(reason));
+				::fprintf(stderr, "TLS handshake failed: %s\n", reason);
+			}
+		}
+		// Records already buffered by OpenSSL would be lost to the kernel.
+		else if(::SSL_has_pending(ssl) || secrets.client_len == 0 || secrets.server_len == 0) {
+			if constexpr(debug_mode) {
+				::fprintf(stderr, "TLS handshake left no usable state for kTLS.\n");
+			}
+		}
+		else if(::setsockopt(sockfd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) == -1) {
+			if constexpr(debug_mode) {
+				::fprintf(stderr, "Failed to attach TLS ULP to socket %d: errno = %d\n", sockfd, errno);
+			}
+		}
+		else {
+			bool const server = ctx.get_role() == tls_role_server;
+			SSL_CIPHER const *cipher = ::SSL_get_current_cipher(ssl);
+			result = ktls_detail::install(sockfd, TLS_TX, cipher,
+			                              server ? secrets.server : secrets.client, server ? secrets.server_len : secrets.client_len)
+			      && ktls_detail::install(sockfd, TLS_RX, cipher,
+			                              server ? secrets.client : secrets.server, server ? secrets.client_len : secrets.server_len);
+			if constexpr(debug_mode) {
+				if(!result) ::fprintf(stderr, "Failed to install kTLS keys on socket %d: errno = %d\n", sockfd, errno);
+			}
+		}
+
+		::OPENSSL_cleanse(&secrets, sizeof(secrets));
+		::SSL_free(ssl);
+		return result;
+	}
+
+	template<sockaddr_type type, bool nonblocking>
+	class tls_transceiver : public tcp_transceiver<type, nonblocking> {
+	public:
+		explicit tls_transceiver() : tcp_transceiver<type, nonblocking>() {}
+
+		explicit tls_transceiver(in_port_t port, in_addr_t ip)
+		  : tcp_transceiver<type, nonblocking>(port, ip) {}
+
+		explicit tls_transceiver(int sockfd, in_port_t port, in_addr_t ip)
+		  : tcp_transceiver<type, nonblocking>(sockfd, port, ip) {}
+
+		explicit tls_transceiver(in_port_t port, std::string_view ip_str)
+		  : tcp_transceiver<type, nonblocking>(port, ip_str) {}
+
+		explicit tls_transceiver(int sockfd, in_port_t port, std::string_view ip_str)
+		  : tcp_transceiver<type, nonblocking>(sockfd, port, ip_str) {}
+
+		// After this succeeds, the inherited send/recv/send_file carry TLS records.
+		[[nodiscard]] bool handshake(tls_context const &ctx) const {
+			return ktls_handshake(ctx, this->sockfd);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef OFCT_NETWORK_tap_tap_reader_hpp
+#define OFCT_NETWORK_tap_tap_reader_hpp
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+
+#include "traffic_tap.hpp"
+
+namespace OFCT::networking {
+
+	struct tap_record {
+		// Since the tap was created.
+		uint64_t timestamp_ns;
+		uint32_t connection;
+		tap_event event;
+		std::span<uint8_t const> data;
+	};
+
+	// Reads a traffic_tap file, oldest record first. Meant for a capture whose writer has finished or
+	// is quiet; records written while reading may be torn.
+	class tap_reader {
+	public:
+		explicit tap_reader(std::string const &path) {
+			int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if(fd == -1) fail(path, errno);
+			struct stat st{};
+			bool const stat_ok = ::fstat(fd, &st) == 0;
+			if(!stat_ok || static_cast<size_t>(st.st_size) < sizeof(tap_file_header)) {
+				int const error = stat_ok ? EINVAL : errno;
+				::close(fd);
+				fail(path, error);
+			}
+			size = static_cast<size_t>(st.st_size);
+			void *const mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+			int const error = errno;
+			::close(fd);
+			if(mapped == MAP_FAILED) fail(path, error);
+			header = static_cast<tap_file_header const*>(mapped);
+			data = static_cast<uint8_t const*>(mapped) + sizeof(tap_file_header);
+			if(header->magic != tap_file_header::MAGIC || header->version != tap_file_header::VERSION || header->capacity % 8
+			   || header->capacity < traffic_tap::MIN_CAPACITY || sizeof(tap_file_header) + header->capacity > size) {
+				::munmap(const_cast<tap_file_header*>(header), size);
+				fail(path, EINVAL);
+			}
+		}
+
+		tap_reader(tap_reader const &) = delete;
+		tap_reader &operator=(tap_reader const &) = delete;
+
+		~tap_reader() {
+			::munmap(const_cast<tap_file_header*>(header), size);
+		}
+
+		[[nodiscard]] uint64_t start_realtime_ns() const { return header->start_realtime_ns; }
+		[[nodiscard]] uint64_t overwritten_count() const { return header->overwritten.load(std::memory_order_relaxed); }
+		[[nodiscard]] uint64_t connection_count() const { return header->connections.load(std::memory_order_relaxed); }
+
+		// Calls callback(tap_record const&) for every record in the ring. Returns false if the ring was found
+		// to be inconsistent part way through.
+		template<typename callback_t>
+		bool for_each(callback_t &&callback) const {
+			uint64_t const capacity = header->capacity;
+			uint64_t const head = header->head.load(std::memory_order_acquire);
+			uint64_t position = header->tail.load(std::memory_order_acquire);
+			while(position < head) {
+				size_t const offset = position % capacity;
+				size_t const remaining = capacity - offset;
+				if(remaining < sizeof(tap_record_header)) {
+					position += remaining;
+					continue;
+				}
+				tap_record_header record;
+				::memcpy(&record, data + offset, sizeof(record));
+				if(record.footprint() > remaining || position + record.footprint() > head) return false;
+				position += record.footprint();
+				if(record.event() == tap_pad) continue;
+				callback(tap_record{record.timestamp_ns, record.connection, record.event(),
+				                    std::span<uint8_t const>(data + offset + sizeof(record), record.length())});
+			}
+			return true;
+		}
+
+	private:
+		tap_file_header const *header = nullptr;
+		uint8_t const *data = nullptr;
+		size_t size = 0;
+
+		[[noreturn]] static void fail(std::string const &path, int error) {
+			if constexpr(debug_mode) {
+				::fprintf(stderr, "Failed to open traffic tap file %s: errno = %d\n", path.c_str(), error);
+			}
+			throw tap_file_failure_exception(path, error);
+		}
+	};
+}
+
+#endif
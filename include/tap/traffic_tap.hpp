@@ -0,0 +1,253 @@
+#ifndef OFCT_NETWORK_tap_traffic_tap_hpp
+#define OFCT_NETWORK_tap_traffic_tap_hpp
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+
+#include "../debug/debug_mode.hpp"
+#include "../exceptions/tap_exceptions.hpp"
+
+namespace OFCT::networking {
+
+	enum class tap_event : uint8_t { NONE, OPEN, RECV, SEND, CLOSE, PEER_CLOSE, PAD };
+
+	// OPEN carries the peer's tap_peer; RECV and SEND the bytes as they passed through the transceiver.
+	// CLOSE is the local side letting go of the connection, PEER_CLOSE a recv that returned 0. PAD fills
+	// the end of the ring when the next record does not fit there.
+	constexpr auto tap_open = tap_event::OPEN;
+	constexpr auto tap_recv = tap_event::RECV;
+	constexpr auto tap_send = tap_event::SEND;
+	constexpr auto tap_close = tap_event::CLOSE;
+	constexpr auto tap_peer_close = tap_event::PEER_CLOSE;
+	constexpr auto tap_pad = tap_event::PAD;
+
+	// On-disk layout, host byte order. The data area after the header is a ring of 8-byte aligned records;
+	// head and tail are positions in an unbounded byte stream, taken modulo capacity.
+	struct tap_file_header {
+		static constexpr uint32_t MAGIC = 0x5041544f; // "OTAP"
+		static constexpr uint32_t VERSION = 1;
+
+		uint32_t magic;
+		uint32_t version;
+		uint64_t capacity;
+		// CLOCK_REALTIME when the tap was created; record timestamps count from it.
+		uint64_t start_realtime_ns;
+		std::atomic_uint64_t head;
+		// Oldest record still in the ring.
+		std::atomic_uint64_t tail;
+		// Records overwritten because the ring wrapped.
+		std::atomic_uint64_t overwritten;
+		std::atomic_uint64_t connections;
+		uint8_t reserved[8];
+	};
+
+	struct tap_record_header {
+		static constexpr uint32_t LENGTH_MASK = (1u << 28) - 1;
+
+		uint64_t timestamp_ns;
+		uint32_t connection;
+		// Event in the top 4 bits, payload length below.
+		uint32_t event_length;
+
+		[[nodiscard]] tap_event event() const { return static_cast<tap_event>(event_length >> 28); }
+		[[nodiscard]] uint32_t length() const { return event_length & LENGTH_MASK; }
+		[[nodiscard]] size_t footprint() const { return sizeof(tap_record_header) + ((length() + 7) & ~size_t(7)); }
+	};
+
+	struct tap_peer {
+		// Network byte order, as in sockaddr_in.
+		in_addr_t ip;
+		in_port_t port;
+		uint16_t reserved;
+	};
+
+	static_assert(sizeof(tap_file_header) == 64 && sizeof(tap_record_header) == 16 && sizeof(tap_peer) == 8);
+
+	struct tap_options {
+		std::string path;
+		// Size of the ring; once full, the oldest records are overwritten.
+		size_t capacity = 64 * 1024 * 1024;
+		// Records one connection in this many. Replay needs whole streams, so sampling picks connections,
+		// never individual sends.
+		uint32_t sample_one_in = 1;
+		bool enabled = true;
+	};
+
+	// Records connections' byte streams with timestamps into a memory-mapped ring file. Attached to a
+	// tcp_transceiver (directly or through a listener's set_tap), it is handed each send and recv after the
+	// syscall returns; recording is a timestamp read, a short critical section and a copy into the mapping,
+	// with no allocation. The file is a complete capture at any moment the writers are quiet, so a sampling
+	// process can be stopped at will and the file replayed with tap_reader.
+	class traffic_tap {
+		static constexpr uint64_t NS = 1'000'000'000;
+
+	public:
+		// Smaller capacities are rounded up to it; tap_reader rejects files below it.
+		static constexpr size_t MIN_CAPACITY = 4096;
+
+		explicit traffic_tap(tap_options const &options)
+		  : capacity(std::max<size_t>((options.capacity + 7) & ~size_t(7), MIN_CAPACITY)),
+		    sample_one_in(std::max<uint32_t>(options.sample_one_in, 1)), enabled(options.enabled) {
+			int const fd = ::open(options.path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if(fd == -1) fail(options.path);
+			size_t const size = sizeof(tap_file_header) + capacity;
+			void *const mapped = ::ftruncate(fd, static_cast<off_t>(size)) == 0
+			                   ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+			int const error = errno;
+			::close(fd);
+			if(mapped == MAP_FAILED) {
+				errno = error;
+				fail(options.path);
+			}
+			header = static_cast<tap_file_header*>(mapped);
+			data = static_cast<uint8_t*>(mapped) + sizeof(tap_file_header);
+
+			timespec realtime{};
+			::clock_gettime(CLOCK_REALTIME, &realtime);
+			::clock_gettime(CLOCK_MONOTONIC, &start);
+			header->magic = tap_file_header::MAGIC;
+			header->version = tap_file_header::VERSION;
+			header->capacity = capacity;
+			header->start_realtime_ns = static_cast<uint64_t>(realtime.tv_sec) * NS + realtime.tv_nsec;
+		}
+
+		traffic_tap(traffic_tap const &) = delete;
+		traffic_tap &operator=(traffic_tap const &) = delete;
+
+		~traffic_tap() {
+			::munmap(header, sizeof(tap_file_header) + capacity);
+		}
+
+		// Starts or stops picking up new connections; connections already being recorded carry on.
+		void set_enabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+
+		// Connection id to pass to record(), or 0 if this connection is not sampled.
+		[[nodiscard]] uint32_t open(in_addr_t peer_ip, in_port_t peer_port) {
+			if(!enabled.load(std::memory_order_relaxed)) return 0;
+			if(opened.fetch_add(1, std::memory_order_relaxed) % sample_one_in) return 0;
+			uint32_t const connection = static_cast<uint32_t>(header->connections.fetch_add(1, std::memory_order_relaxed) + 1);
+			tap_peer const peer{peer_ip, peer_port, 0};
+			record(connection, tap_open, &peer, sizeof(peer));
+			return connection;
+		}
+
+		void record(uint32_t connection, tap_event event, void const *buf, size_t len) {
+			iovec const iov{const_cast<void*>(buf), len};
+			record(connection, event, &iov, 1, len);
+		}
+
+		// The first len bytes gathered from iov, as after a partial sendmsg.
+		void record(uint32_t connection, tap_event event, iovec const *iov, int iovcnt, size_t len) {
+			// Large writes are split so one record never claims more than a fraction of the ring.
+			size_t const max_payload = std::min<size_t>(capacity / 8, tap_record_header::LENGTH_MASK) & ~size_t(7);
+			size_t iov_offset = 0;
+			std::lock_guard<std::mutex> lock(mutex);
+			// Taken under the lock so timestamps never go backwards in the file.
+			uint64_t const timestamp = now();
+			do {
+				size_t const chunk = std::min(len, max_payload);
+				tap_record_header const record{timestamp, connection, static_cast<uint32_t>(event) << 28 | static_cast<uint32_t>(chunk)};
+				uint64_t const new_head = reserve(record);
+				uint8_t *const payload = data + (new_head - record.footprint()) % capacity + sizeof(record);
+				size_t copied = 0;
+				while(copied < chunk) {
+					size_t const size = std::min(chunk - copied, iov->iov_len - iov_offset);
+					::memcpy(payload + copied, static_cast<uint8_t const*>(iov->iov_base) + iov_offset, size);
+					copied += size;
+					iov_offset += size;
+					if(iov_offset == iov->iov_len && iovcnt > 1) {
+						++iov;
+						--iovcnt;
+						iov_offset = 0;
+					}
+				}
+				// Published only now, so a reader that sees the new head also sees the payload.
+				header->head.store(new_head, std::memory_order_release);
+				len -= chunk;
+			} while(len);
+		}
+
+		[[nodiscard]] uint64_t overwritten_count() const { return header->overwritten.load(std::memory_order_relaxed); }
+		[[nodiscard]] uint64_t connection_count() const { return header->connections.load(std::memory_order_relaxed); }
+		[[nodiscard]] uint64_t bytes_written() const { return header->head.load(std::memory_order_relaxed); }
+
+	private:
+		size_t const capacity;
+		uint32_t const sample_one_in;
+		std::atomic_bool enabled;
+		std::atomic_uint64_t opened = 0;
+		tap_file_header *header = nullptr;
+		uint8_t *data = nullptr;
+		timespec start{};
+		std::mutex mutex;
+
+		[[noreturn]] static void fail(std::string const &path) {
+			int const error = errno;
+			if constexpr(debug_mode) {
+				::fprintf(stderr, "Failed to open traffic tap file %s: errno = %d\n", path.c_str(), error);
+			}
+			throw tap_file_failure_exception(path, error);
+		}
+
+		[[nodiscard]] uint64_t now() const {
+			timespec ts{};
+			::clock_gettime(CLOCK_MONOTONIC, &ts);
+			return static_cast<uint64_t>(ts.tv_sec - start.tv_sec) * NS + ts.tv_nsec - start.tv_nsec;
+		}
+
+		// Writes the record header and returns the head just past the record, which the caller publishes once
+		// the payload is in place; records never straddle the end of the ring.
+		[[nodiscard]] uint64_t reserve(tap_record_header const &record) {
+			uint64_t head = header->head.load(std::memory_order_relaxed);
+			size_t const footprint = record.footprint();
+			size_t const remaining = capacity - head % capacity;
+			if(remaining < footprint) {
+				make_room(head + remaining);
+				// A gap too small for a header is skipped by readers without one.
+				if(remaining >= sizeof(tap_record_header)) {
+					tap_record_header const pad{record.timestamp_ns, 0, static_cast<uint32_t>(tap_pad) << 28 | static_cast<uint32_t>(remaining - sizeof(tap_record_header))};
+					::memcpy(data + head % capacity, &pad, sizeof(pad));
+				}
+				head += remaining;
+			}
+			make_room(head + footprint);
+			uint8_t *const slot = data + head % capacity;
+			::memcpy(slot, &record, sizeof(record));
+			return head + footprint;
+		}
+
+		// Drops the oldest records until the ring can hold everything up to new_head.
+		void make_room(uint64_t new_head) {
+			uint64_t tail = header->tail.load(std::memory_order_relaxed);
+			uint64_t dropped = 0;
+			while(new_head - tail > capacity) {
+				size_t const remaining = capacity - tail % capacity;
+				if(remaining < sizeof(tap_record_header)) {
+					tail += remaining;
+					continue;
+				}
+				tap_record_header record;
+				::memcpy(&record, data + tail % capacity, sizeof(record));
+				tail += record.footprint();
+				if(record.event() != tap_pad) ++dropped;
+			}
+			header->tail.store(tail, std::memory_order_release);
+			if(dropped) header->overwritten.fetch_add(dropped, std::memory_order_relaxed);
+		}
+	};
+}
+
+#endif
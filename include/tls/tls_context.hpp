@@ -0,0 +1,131 @@
+#ifndef OFCT_NETWORK_tls_tls_context_hpp
+#define OFCT_NETWORK_tls_tls_context_hpp
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "../debug/debug_mode.hpp"
+#include "../exceptions/tls_exceptions.hpp"
+
+namespace OFCT::networking {
+
+	enum class tls_role { NONE, SERVER, CLIENT };
+
+	constexpr auto tls_role_server = tls_role::SERVER;
+	constexpr auto tls_role_client = tls_role::CLIENT;
+
+	// Application traffic secrets of one connection, filled in by the keylog callback during the handshake.
+	struct tls_traffic_secrets {
+		static constexpr size_t MAX_SECRET_SIZE = EVP_MAX_MD_SIZE;
+
+		uint8_t client[MAX_SECRET_SIZE];
+		size_t client_len = 0;
+		uint8_t server[MAX_SECRET_SIZE];
+		size_t server_len = 0;
+	};
+
+	// TLS 1.3 only; the record layer is meant to be handed over to the kernel (kTLS) right after the handshake.
+	class tls_context {
+	public:
+		explicit tls_context(tls_role role)
+		  : role(role), ctx(::SSL_CTX_new(role == tls_role_server ? ::TLS_server_method() : ::TLS_client_method())) {
+			if(ctx == nullptr) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to generate TLS context.\n");
+				}
+				throw tls_context_generation_failed_exception();
+			}
+			::SSL_CTX_set_min_proto_version(ctx, TLS1_3_VERSION);
+			::SSL_CTX_set_max_proto_version(ctx, TLS1_3_VERSION);
+			::SSL_CTX_set_ciphersuites(ctx, "TLS_AES_128_GCM_SHA256:TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256");
+			// Session tickets are sent with the application keys after the handshake and would desync the kernel's sequence number.
+			::SSL_CTX_set_num_tickets(ctx, 0);
+			::SSL_CTX_set_keylog_callback(ctx, keylog);
+		}
+
+		explicit tls_context(tls_role role, std::string_view cert_path, std::string_view key_path) : tls_context(role) {
+			if(::SSL_CTX_use_certificate_chain_file(ctx, cert_path.data()) != 1) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to load certificate: %s\n", cert_path.data());
+				}
+				throw tls_certificate_load_failure_exception(cert_path);
+			}
+			if(::SSL_CTX_use_PrivateKey_file(ctx, key_path.data(), SSL_FILETYPE_PEM) != 1 || ::SSL_CTX_check_private_key(ctx) != 1) {
+				if constexpr(debug_mode) {
+					::fprintf(stderr, "Failed to load private key: %s\n", key_path.data());
+				}
+				throw tls_certificate_load_failure_exception(key_path);
+			}
+		}
+
+		tls_context(tls_context const &) = delete;
+		tls_context &operator=(tls_context const &) = delete;
+
+		~tls_context() {
+			::SSL_CTX_free(ctx);
+		}
+
+		[[nodiscard]] bool use_certificate(X509 *cert, EVP_PKEY *key) const {
+			return ::SSL_CTX_use_certificate(ctx, cert) == 1
+			    && ::SSL_CTX_use_PrivateKey(ctx, key) == 1
+			    && ::SSL_CTX_check_private_key(ctx) == 1;
+		}
+
+		// Enables peer verification against the given CA file.
+		[[nodiscard]] bool verify_peer(std::string_view ca_path) const {
+			if(::SSL_CTX_load_verify_locations(ctx, ca_path.data(), nullptr) != 1) return false;
+			::SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, nullptr);
+			return true;
+		}
+
+		[[nodiscard]] tls_role get_role() const { return role; }
+		[[nodiscard]] SSL_CTX *native_handle() const { return ctx; }
+
+	private:
+		tls_role role;
+		SSL_CTX *ctx;
+
+		// line = "<LABEL> <client random hex> <secret hex>"
+		static void keylog(SSL const *ssl, char const *line) {
+			auto *secrets = static_cast<tls_traffic_secrets*>(SSL_get_app_data(ssl));
+			if(secrets == nullptr) return;
+
+			std::string_view const view(line);
+			constexpr std::string_view client_label = "CLIENT_TRAFFIC_SECRET_0 ";
+			constexpr std::string_view server_label = "SERVER_TRAFFIC_SECRET_0 ";
+			uint8_t *out;
+			size_t *out_len;
+			if(view.substr(0, client_label.size()) == client_label) {
+				out = secrets->client;
+				out_len = &secrets->client_len;
+			}
+			else if(view.substr(0, server_label.size()) == server_label) {
+				out = secrets->server;
+				out_len = &secrets->server_len;
+			}
+			else return;
+
+			size_t const pos = view.rfind(' ');
+			std::string_view const hex = view.substr(pos + 1);
+			if(hex.size() % 2 || hex.size() / 2 > tls_traffic_secrets::MAX_SECRET_SIZE) return;
+			for(size_t i = 0; i < hex.size() / 2; ++i) {
+				out[i] = static_cast<uint8_t>(hex_value(hex[2 * i]) << 4 | hex_value(hex[2 * i + 1]));
+			}
+			*out_len = hex.size() / 2;
+		}
+
+		static constexpr uint8_t hex_value(char c) {
+			if(c >= '0' && c <= '9') return c - '0';
+			if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+			if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+			return 0;
+		}
+	};
+}
+
+#endif
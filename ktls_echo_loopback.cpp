@@ -0,0 +1,86 @@
+#include "include/socket/tcp_client.hpp"
+#include "include/socket/tcp_listener.hpp"
+#include "include/socket/tls_transceiver.hpp"
+
+#include <openssl/x509.h>
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+// g++ -std=c++20 ktls_echo_loopback.cpp -lssl -lcrypto (needs the `tls` kernel module)
+
+namespace net = OFCT::networking;
+
+class ktls_echo_server
+: public net::tcp_listener<net::sockaddr_type_in, false> {
+public:
+	explicit ktls_echo_server(net::tls_context const &ctx, in_port_t port, std::string_view ip_str)
+	  : net::tcp_listener<net::sockaddr_type_in, false>(port, ip_str), ctx(ctx) {}
+
+protected:
+	virtual bool transceive(std::atomic_bool const &, net::tcp_transceiver<net::sockaddr_type_in, false> const &transceiver) final {
+		if(!net::ktls_handshake(ctx, transceiver.native_handle())) return false;
+		uint8_t buffer[1024]{};
+		ssize_t const received = transceiver.recv_raw(buffer, sizeof(buffer));
+		if(received <= 0) return false;
+		return transceiver.send(buffer, received);
+	}
+
+private:
+	net::tls_context const &ctx;
+};
+
+static bool make_self_signed(net::tls_context const &ctx) {
+	EVP_PKEY *key = ::EVP_EC_gen("P-256");
+	X509 *cert = ::X509_new();
+	::X509_set_version(cert, 2);
+	::ASN1_INTEGER_set(::X509_get_serialNumber(cert), 1);
+	::X509_gmtime_adj(::X509_getm_notBefore(cert), 0);
+	::X509_gmtime_adj(::X509_getm_notAfter(cert), 60 * 60);
+	::X509_set_pubkey(cert, key);
+	X509_NAME *name = ::X509_get_subject_name(cert);
+	::X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<unsigned char const*>("localhost"), -1, -1, 0);
+	::X509_set_issuer_name(cert, name);
+	bool const result = ::X509_sign(cert, key, ::EVP_sha256()) > 0 && ctx.use_certificate(cert, key);
+	::X509_free(cert);
+	::EVP_PKEY_free(key);
+	return result;
+}
+
+int main() {
+	net::tls_context server_ctx(net::tls_role_server);
+	net::tls_context client_ctx(net::tls_role_client);
+	if(!make_self_signed(server_ctx)) {
+		::printf("Failed to generate self-signed certificate.\n");
+		return 1;
+	}
+
+	ktls_echo_server server(server_ctx, 9998, "127.0.0.1");
+	std::atomic_bool flag_quit(false);
+	std::thread thread([&server, &flag_quit]() {
+		try {
+			server.loop(flag_quit);
+		}
+		catch(std::exception const &e) {
+			::printf("server: %s\n", e.what());
+		}
+	});
+	thread.detach();
+
+	net::tcp_client<net::sockaddr_type_in, false> client(9998, "127.0.0.1");
+	while(!client.connect()) std::this_thread::yield();
+	if(!net::ktls_handshake(client_ctx, client.native_handle())) {
+		::printf("client: kTLS handshake failed.\n");
+		return 1;
+	}
+
+	std::string const message = "hello over kTLS";
+	std::string received;
+	if(!client.send(message) || !client.recv(received, message.size())) {
+		::printf("client: Failed to transceive.\n");
+		return 1;
+	}
+	std::cout << received << '\n';
+	flag_quit.store(true, std::memory_order_seq_cst);
+}
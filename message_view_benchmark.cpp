@@ -0,0 +1,89 @@
+#include "include/message/message_view.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Decoding fixed-layout RPC messages: copy into a vector per message and parse into a heap object
+// (today's recv(std::vector<uint8_t>&, len) pattern) vs. typed views straight over the receive buffer.
+
+namespace net = OFCT::networking;
+
+struct rpc_request {
+	using request_id = net::field<uint64_t, 0>;
+	using method = net::field<uint16_t, 8>;
+	using flags = net::field<uint16_t, 10>;
+	using length = net::field<uint32_t, 12>;
+	using body = net::bytes_field<16, 48>;
+	using layout = net::message_layout<64, request_id, method, flags, length, body>;
+};
+
+static_assert(rpc_request::layout::size == 64);
+static_assert(rpc_request::request_id::aligned && rpc_request::length::aligned);
+
+struct parsed_request {
+	uint64_t request_id;
+	uint16_t method;
+	uint16_t flags;
+	uint32_t length;
+	std::vector<uint8_t> body;
+};
+
+static uint64_t be64(uint8_t const *p) {
+	uint64_t value = 0;
+	for(int i = 0; i < 8; ++i) value = value << 8 | p[i];
+	return value;
+}
+
+static uint32_t be32(uint8_t const *p) { return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3]; }
+static uint16_t be16(uint8_t const *p) { return uint16_t(p[0] << 8 | p[1]); }
+
+int main() {
+	constexpr size_t messages = 1 << 20;
+	constexpr size_t rounds = 10;
+	constexpr size_t size = rpc_request::layout::size;
+
+	std::vector<uint8_t> receive_buffer(messages * size);
+	uint8_t body[48];
+	for(size_t i = 0; i < sizeof(body); ++i) body[i] = static_cast<uint8_t>(i);
+	for(size_t i = 0; i < messages; ++i) {
+		net::message_writer<rpc_request::layout>::wrap(std::span(receive_buffer).subspan(i * size))
+		  ->set<rpc_request::request_id>(uint64_t(i))
+		  .set<rpc_request::method>(uint16_t(i % 17))
+		  .set<rpc_request::flags>(uint16_t(1))
+		  .set<rpc_request::length>(uint32_t(48))
+		  .set<rpc_request::body>(std::span<uint8_t const, 48>(body));
+	}
+
+	uint64_t copy_checksum = 0;
+	auto begin = std::chrono::steady_clock::now();
+	for(size_t round = 0; round < rounds; ++round) {
+		for(size_t i = 0; i < messages; ++i) {
+			std::vector<uint8_t> buf(size);
+			::memcpy(buf.data(), receive_buffer.data() + i * size, size);
+			auto request = std::make_unique<parsed_request>();
+			request->request_id = be64(buf.data());
+			request->method = be16(buf.data() + 8);
+			request->flags = be16(buf.data() + 10);
+			request->length = be32(buf.data() + 12);
+			request->body.assign(buf.begin() + 16, buf.end());
+			copy_checksum += request->request_id + request->method + request->flags + request->length + request->body[47];
+		}
+	}
+	double const copy_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / (messages * rounds);
+
+	uint64_t view_checksum = 0;
+	begin = std::chrono::steady_clock::now();
+	for(size_t round = 0; round < rounds; ++round) {
+		net::for_each_message<rpc_request::layout>(receive_buffer, [&](net::message_view<rpc_request::layout> const &view) {
+			view_checksum += view.get<rpc_request::request_id>() + view.get<rpc_request::method>() + view.get<rpc_request::flags>()
+			               + view.get<rpc_request::length>() + view.get<rpc_request::body>()[47];
+		});
+	}
+	double const view_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / (messages * rounds);
+
+	::printf("copy + heap parse  %7.2f ns/message\n", copy_ns);
+	::printf("typed view         %7.2f ns/message\n", view_ns);
+	::printf("(checksums %s)\n", copy_checksum == view_checksum ? "match" : "DIFFER");
+}
@@ -0,0 +1,142 @@
+#include "include/numa/node_pool.hpp"
+#include "include/numa/numa_topology.hpp"
+#include "include/socket/reuseport_group.hpp"
+#include "include/socket/tcp_client.hpp"
+#include "include/socket/tcp_server.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// One echo worker per usable CPU, pinned to it, with its connection buffers in a pool on its own NUMA node and
+// connections steered to it by the CPU that received them. Clients are pinned round the same CPUs; on loopback
+// the SYN is processed on the sending CPU, so every connection should be accepted by the worker on that CPU.
+
+namespace net = OFCT::networking;
+
+constexpr in_port_t PORT = 9985;
+constexpr size_t MESSAGE_SIZE = 256;
+constexpr size_t POOL_BLOCKS = 16;
+
+struct worker_stats {
+	std::atomic_size_t connections = 0;
+	// Connections whose packets were processed on the worker's own CPU.
+	std::atomic_size_t local = 0;
+	std::atomic_bool finished = false;
+};
+
+struct echo_handler {
+	net::node_pool *pool;
+	worker_stats *stats;
+	int cpu;
+
+	bool transceive(std::atomic_bool const &, net::tcp_transceiver<net::sockaddr_type_in, false> const &transceiver) {
+		int incoming_cpu = -1;
+		socklen_t len = sizeof(incoming_cpu);
+		::getsockopt(transceiver.native_handle(), SOL_SOCKET, SO_INCOMING_CPU, &incoming_cpu, &len);
+		stats->connections.fetch_add(1, std::memory_order_relaxed);
+		if(incoming_cpu == cpu) stats->local.fetch_add(1, std::memory_order_relaxed);
+
+		uint8_t *const buffer = static_cast<uint8_t*>(pool->allocate());
+		if(!buffer) return true;
+		while(true) {
+			ssize_t const received = transceiver.recv_raw(buffer, MESSAGE_SIZE);
+			if(received <= 0 || !transceiver.send(buffer, received)) break;
+		}
+		pool->deallocate(buffer);
+		return true;
+	}
+};
+
+using server_t = net::tcp_server<net::sockaddr_type_in, false, echo_handler>;
+
+int main(int argc, char **argv) {
+	size_t const connections_per_cpu = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50;
+	size_t const round_trips = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+
+	net::numa_topology const topology = net::numa_topology::detect();
+	::printf("%zu NUMA node(s)%s\n", topology.node_count(), topology.is_numa() ? "" : ", running without node placement");
+	for(auto const &node : topology.get_nodes()) {
+		::printf("  node %d: cpus", node.id);
+		for(int cpu : node.cpus) ::printf(" %d", cpu);
+		::printf("\n");
+	}
+
+	std::vector<int> const cpus = topology.cpus();
+	net::reuseport_group group(PORT, "127.0.0.1", cpus);
+	::printf("reuseport steering %s\n", group.is_steered() ? "attached" : "unavailable, kernel hash in use");
+
+	std::atomic_bool flag_quit(false);
+	// Filled before any worker starts; each worker gets its own entry by value and never touches the vector.
+	std::vector<std::unique_ptr<worker_stats>> stats;
+	for(size_t i = 0; i < group.size(); ++i) stats.push_back(std::make_unique<worker_stats>());
+	std::vector<std::thread> workers;
+	for(size_t i = 0; i < group.size(); ++i) {
+		workers.emplace_back([&, i, mine = stats[i].get(), sockfd = group.release(i)]() {
+			int const cpu = group.cpu_of(i);
+			if(!net::pin_current_thread(cpu)) ::fprintf(stderr, "worker %zu: failed to pin to cpu %d\n", i, cpu);
+			// Built after pinning, so the pages are first touched on the worker's node even without mbind.
+			net::node_pool pool(topology.node_of(cpu), MESSAGE_SIZE, POOL_BLOCKS);
+			server_t server(echo_handler{&pool, mine, cpu}, net::inherit_socket, sockfd);
+			server.loop(flag_quit);
+			mine->finished.store(true, std::memory_order_release);
+		});
+	}
+
+	auto const begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> clients;
+	std::atomic_size_t failed = 0;
+	for(int cpu : cpus) {
+		clients.emplace_back([&, cpu]() {
+			(void) net::pin_current_thread(cpu);
+			uint8_t message[MESSAGE_SIZE]{};
+			for(size_t c = 0; c < connections_per_cpu; ++c) {
+				net::tcp_client<net::sockaddr_type_in, false> client(PORT, "127.0.0.1");
+				if(!client.connect()) {
+					failed.fetch_add(1, std::memory_order_relaxed);
+					continue;
+				}
+				for(size_t r = 0; r < round_trips; ++r) {
+					if(!client.send(message, sizeof(message)) || !client.recv(message, sizeof(message))) {
+						failed.fetch_add(1, std::memory_order_relaxed);
+						break;
+					}
+				}
+			}
+		});
+	}
+	for(std::thread &client : clients) client.join();
+	double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	size_t total = 0;
+	size_t local = 0;
+	for(size_t i = 0; i < group.size(); ++i) {
+		size_t const served = stats[i]->connections.load();
+		::printf("worker %zu (cpu %d, node %d): %zu connections, %zu on its own cpu\n", i, group.cpu_of(i), topology.node_of(group.cpu_of(i)), served,
+		         stats[i]->local.load());
+		total += served;
+		local += stats[i]->local.load();
+	}
+	::printf("%zu connections, %zu failed, %.0f round trips/s, %.1f%% handled on the receiving cpu\n", total, failed.load(),
+	         total * round_trips / seconds, total ? 100.0 * local / total : 0.0);
+
+	// Each blocked accept needs one more connection to notice the flag; connect from every worker's cpu until all are out.
+	flag_quit.store(true, std::memory_order_release);
+	for(size_t attempt = 0; attempt < 64; ++attempt) {
+		bool all_finished = true;
+		for(size_t i = 0; i < group.size(); ++i) {
+			if(stats[i]->finished.load(std::memory_order_acquire)) continue;
+			all_finished = false;
+			std::thread([&, i]() {
+				(void) net::pin_current_thread(group.cpu_of(i));
+				net::tcp_client<net::sockaddr_type_in, false> waker(PORT, "127.0.0.1");
+				(void) waker.connect();
+			}).join();
+		}
+		if(all_finished) break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	for(std::thread &worker : workers) worker.join();
+}
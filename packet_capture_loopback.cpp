@@ -0,0 +1,102 @@
+#include "include/socket/packet_ring.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Captures a UDP burst on lo with a fanout group of TPACKET_V3 rings, one per thread, and reports how many
+// packets each poll() returned. Needs CAP_NET_RAW.
+
+namespace net = OFCT::networking;
+
+constexpr in_port_t PORT = 9989;
+
+struct capture_stats {
+	uint64_t packets = 0;
+	uint64_t blocks = 0;
+};
+
+int main(int argc, char **argv) {
+	size_t const datagrams = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200'000;
+	size_t const threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2;
+
+	net::packet_ring_options options;
+	options.interface = "lo";
+	options.block_timeout_ms = 5;
+	options.fanout = net::fanout_hash;
+	options.fanout_group = static_cast<uint16_t>(::getpid());
+
+	std::vector<std::unique_ptr<net::packet_ring>> rings;
+	try {
+		for(size_t i = 0; i < threads; ++i) rings.push_back(std::make_unique<net::packet_ring>(options));
+	}
+	catch(std::exception const &e) {
+		::printf("%s (CAP_NET_RAW is required)\n", e.what());
+		return 1;
+	}
+
+	std::atomic_bool flag_quit(false);
+	std::vector<capture_stats> stats(threads);
+	std::vector<std::thread> workers;
+	for(size_t i = 0; i < threads; ++i) {
+		workers.emplace_back([&, i]() {
+			while(!flag_quit.load(std::memory_order_acquire)) {
+				size_t const count = rings[i]->poll(100, [&](net::captured_packet const &packet) {
+					// Ethernet (zeroed on lo), IPv4, UDP to PORT; lo shows each packet leaving and arriving.
+					if(packet.packet_type == PACKET_OUTGOING || packet.data.size() < 14 + sizeof(iphdr) + sizeof(udphdr)) return;
+					iphdr const *ip = reinterpret_cast<iphdr const*>(packet.data.data() + 14);
+					if(ip->protocol != IPPROTO_UDP) return;
+					udphdr const *udp = reinterpret_cast<udphdr const*>(packet.data.data() + 14 + ip->ihl * 4);
+					if(ntohs(udp->dest) == PORT) ++stats[i].packets;
+				});
+				if(count) ++stats[i].blocks;
+			}
+		});
+	}
+
+	// Several flows, so the hash fanout has something to spread.
+	int const receiver = ::socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	::bind(receiver, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+	std::vector<int> senders;
+	for(int i = 0; i < 8; ++i) senders.push_back(::socket(AF_INET, SOCK_DGRAM, 0));
+
+	uint8_t payload[64]{};
+	uint8_t sink[64];
+	auto const begin = std::chrono::steady_clock::now();
+	for(size_t i = 0; i < datagrams; ++i) {
+		::sendto(senders[i % senders.size()], payload, sizeof(payload), 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+		// Drain as we go so the receiving socket never drops.
+		while(::recv(receiver, sink, sizeof(sink), MSG_DONTWAIT) > 0) {}
+	}
+	double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	flag_quit.store(true, std::memory_order_release);
+	for(std::thread &worker : workers) worker.join();
+
+	uint64_t captured = 0;
+	uint64_t blocks = 0;
+	uint64_t dropped = 0;
+	for(size_t i = 0; i < threads; ++i) {
+		tpacket_stats_v3 const ring_stats = rings[i]->stats();
+		::printf("ring %zu  packets %8lu  blocks %6lu  kernel drops %u\n", i, stats[i].packets, stats[i].blocks, ring_stats.tp_drops);
+		captured += stats[i].packets;
+		blocks += stats[i].blocks;
+		dropped += ring_stats.tp_drops;
+	}
+	::printf("sent %zu in %.3f s (%.0f pps), captured %lu, dropped %lu, %.1f packets per poll\n", datagrams, seconds, datagrams / seconds,
+	         captured, dropped, blocks ? double(captured) / blocks : 0.0);
+
+	for(int fd : senders) ::close(fd);
+	::close(receiver);
+}
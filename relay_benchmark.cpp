@@ -0,0 +1,118 @@
+#include "include/proxy/tcp_relay.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+// Relay throughput and added round-trip latency over loopback, direct vs. through tcp_relay.
+
+namespace net = OFCT::networking;
+
+class echo_upstream
+: public net::tcp_listener<net::sockaddr_type_in, false> {
+public:
+	explicit echo_upstream(in_port_t port, std::string_view ip_str)
+	  : net::tcp_listener<net::sockaddr_type_in, false>(port, ip_str) {}
+
+protected:
+	virtual bool transceive(std::atomic_bool const &, net::tcp_transceiver<net::sockaddr_type_in, false> const &transceiver) final {
+		static uint8_t buffer[64 * 1024];
+		while(true) {
+			ssize_t const received = transceiver.recv_raw(buffer, sizeof(buffer));
+			if(received <= 0) return true;
+			if(!transceiver.send(buffer, received)) return true;
+		}
+	}
+};
+
+// The listeners only start listening once their loop() runs.
+static bool connect(net::tcp_client<net::sockaddr_type_in, false> const &client) {
+	for(int attempt = 0; attempt < 100; ++attempt) {
+		if(client.connect()) return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return false;
+}
+
+// Unblocks a loop() waiting in accept() so it can see flag_quit.
+static void wake(in_port_t port) {
+	net::tcp_client<net::sockaddr_type_in, false> waker(port, "127.0.0.1");
+	(void) waker.connect();
+}
+
+static void measure_latency(char const *name, in_port_t port, size_t iterations) {
+	net::tcp_client<net::sockaddr_type_in, false> client(port, "127.0.0.1");
+	if(!connect(client)) {
+		::printf("%s: Failed to connect.\n", name);
+		return;
+	}
+	int const one = 1;
+	::setsockopt(client.native_handle(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	uint8_t message[64]{};
+	std::vector<double> samples;
+	samples.reserve(iterations);
+	for(size_t i = 0; i < iterations; ++i) {
+		auto const begin = std::chrono::steady_clock::now();
+		if(!client.send(message, sizeof(message)) || !client.recv(message, sizeof(message))) return;
+		samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+	}
+	std::sort(samples.begin(), samples.end());
+	::printf("%-8s rtt  p50 %8.2f us  p99 %8.2f us\n", name, samples[samples.size() / 2], samples[samples.size() * 99 / 100]);
+}
+
+static void measure_throughput(char const *name, in_port_t port, size_t total) {
+	net::tcp_client<net::sockaddr_type_in, false> client(port, "127.0.0.1");
+	if(!connect(client)) {
+		::printf("%s: Failed to connect.\n", name);
+		return;
+	}
+	auto const begin = std::chrono::steady_clock::now();
+	std::thread writer([&client, total]() {
+		static uint8_t chunk[64 * 1024]{};
+		for(size_t sent = 0; sent < total; sent += sizeof(chunk)) {
+			if(client.send_raw(chunk, sizeof(chunk)) <= 0) break;
+		}
+		::shutdown(client.native_handle(), SHUT_WR);
+	});
+	static uint8_t buffer[64 * 1024];
+	size_t received = 0;
+	while(true) {
+		ssize_t const n = client.recv_raw(buffer, sizeof(buffer));
+		if(n <= 0) break;
+		received += n;
+	}
+	writer.join();
+	double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	::printf("%-8s echo %8.1f MiB/s (%zu bytes each way)\n", name, received / seconds / (1024 * 1024), received);
+}
+
+int main() {
+	constexpr in_port_t upstream_port = 9997;
+	constexpr in_port_t relay_port = 9996;
+	constexpr size_t iterations = 20000;
+	constexpr size_t total = size_t(512) << 20;
+
+	std::atomic_bool flag_quit(false);
+	echo_upstream upstream(upstream_port, "127.0.0.1");
+	std::thread upstream_thread([&]() { upstream.loop(flag_quit); });
+	{
+		net::tcp_relay<net::balance_round_robin> relay(relay_port, "127.0.0.1", {{upstream_port, INADDR_LOOPBACK}});
+		std::thread accept_thread([&]() { relay.loop(flag_quit); });
+		std::thread relay_thread([&]() { relay.relay_loop(flag_quit); });
+
+		measure_latency("direct", upstream_port, iterations);
+		measure_latency("relay", relay_port, iterations);
+		measure_throughput("direct", upstream_port, total);
+		measure_throughput("relay", relay_port, total);
+
+		flag_quit.store(true, std::memory_order_seq_cst);
+		wake(relay_port);
+		accept_thread.join();
+		relay_thread.join();
+	}
+	// The relay has closed its sessions, so the upstream is not stuck serving one of them.
+	wake(upstream_port);
+	upstream_thread.join();
+}
@@ -0,0 +1,110 @@
+#include "include/rpc/rpc_client.hpp"
+#include "include/rpc/rpc_handler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+// One connection, two calling disciplines against the same rpc_handler echo service: one request
+// outstanding at a time (echo_blocking_client's model) vs. rpc_client with a window of calls in flight.
+
+namespace net = OFCT::networking;
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr in_port_t PORT = 9993;
+constexpr size_t BODY_SIZE = 64;
+
+struct echo_service {
+	net::rpc_status operator()(uint16_t, std::span<uint8_t const> body, std::vector<uint8_t> &response) {
+		response.assign(body.begin(), body.end());
+		return net::rpc_status_ok;
+	}
+};
+
+static void report(char const *name, std::vector<double> &samples, double seconds) {
+	std::sort(samples.begin(), samples.end());
+	::printf("%-12s %10.0f req/s  p50 %8.1f us  p99 %8.1f us  p99.9 %8.1f us\n", name, samples.size() / seconds,
+	         samples[samples.size() / 2], samples[samples.size() * 99 / 100], samples[samples.size() * 999 / 1000]);
+}
+
+static void run_sequential(size_t requests) {
+	net::tcp_client<net::sockaddr_type_in, false> client(PORT, "127.0.0.1");
+	bool connected = false;
+	for(int attempt = 0; attempt < 100 && !(connected = client.connect()); ++attempt) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	if(!connected) {
+		::printf("sequential: Failed to connect.\n");
+		return;
+	}
+	int const one = 1;
+	::setsockopt(client.native_handle(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	uint8_t const body[BODY_SIZE]{};
+	std::vector<uint8_t> request;
+	uint8_t response[net::rpc_frame::HEADER_SIZE + BODY_SIZE];
+	std::vector<double> samples;
+	samples.reserve(requests);
+	auto const begin = clock_type::now();
+	for(size_t i = 0; i < requests; ++i) {
+		auto const sent_at = clock_type::now();
+		request.clear();
+		net::rpc_frame::append(request, i, 1, net::rpc_status_ok, body);
+		if(!client.send(request.data(), request.size()) || !client.recv(response, sizeof(response))) return;
+		samples.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - sent_at).count());
+	}
+	report("sequential", samples, std::chrono::duration<double>(clock_type::now() - begin).count());
+}
+
+static void run_multiplexed(size_t requests, size_t window) {
+	net::rpc_client client(PORT, "127.0.0.1");
+	bool connected = false;
+	for(int attempt = 0; attempt < 100 && !(connected = client.connect()); ++attempt) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	if(!connected) {
+		::printf("multiplexed: Failed to connect.\n");
+		return;
+	}
+
+	uint8_t const body[BODY_SIZE]{};
+	std::vector<double> samples(requests);
+	std::atomic_size_t completed = 0;
+	std::atomic_size_t failed = 0;
+	auto const begin = clock_type::now();
+	for(size_t i = 0; i < requests; ++i) {
+		while(i - completed.load(std::memory_order_acquire) >= window) std::this_thread::yield();
+		auto const sent_at = clock_type::now();
+		bool const submitted = client.call(1, body, [&, i, sent_at](net::rpc_status status, std::span<uint8_t const> response) {
+			if(status != net::rpc_status_ok || response.size() != BODY_SIZE) failed.fetch_add(1, std::memory_order_relaxed);
+			samples[i] = std::chrono::duration<double, std::micro>(clock_type::now() - sent_at).count();
+			completed.fetch_add(1, std::memory_order_release);
+		});
+		if(!submitted) {
+			::printf("multiplexed: Connection lost.\n");
+			return;
+		}
+	}
+	while(completed.load(std::memory_order_acquire) < requests) std::this_thread::yield();
+	double const seconds = std::chrono::duration<double>(clock_type::now() - begin).count();
+
+	char name[32];
+	::snprintf(name, sizeof(name), "window %zu", window);
+	report(name, samples, seconds);
+	if(failed) ::printf("  (%zu failed)\n", failed.load());
+}
+
+int main(int argc, char **argv) {
+	size_t const requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200'000;
+
+	net::tcp_server<net::sockaddr_type_in, false, net::rpc_handler<echo_service>> server(net::rpc_handler<echo_service>(echo_service{}), PORT, "127.0.0.1");
+	std::atomic_bool flag_quit(false);
+	std::thread server_thread([&]() { server.loop(flag_quit); });
+
+	// The blocking server takes one connection at a time; each run closes its connection before the next.
+	run_sequential(requests / 4);
+	for(size_t window : {16, 256, 4096}) run_multiplexed(requests, window);
+
+	flag_quit.store(true, std::memory_order_release);
+	net::tcp_client<net::sockaddr_type_in, false> waker(PORT, "127.0.0.1");
+	(void) waker.connect();
+	server_thread.join();
+}
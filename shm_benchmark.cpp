@@ -0,0 +1,113 @@
+#include "include/shm/shm_transceiver.hpp"
+#include "include/socket/tcp_client.hpp"
+#include "include/socket/tcp_server.hpp"
+
+#include <netinet/tcp.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+// Round-trip latency and echo throughput to another process, loopback TCP vs. shm_transceiver, driven
+// through the same send/recv calls.
+
+namespace net = OFCT::networking;
+
+constexpr in_port_t PORT = 9986;
+constexpr char const *CONTROL_PATH = "/tmp/ofct_shm_benchmark.sock";
+constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+template<typename transceiver_t>
+static void echo(transceiver_t const &transceiver) {
+	std::vector<uint8_t> buffer(CHUNK_SIZE);
+	while(true) {
+		ssize_t const received = transceiver.recv_raw(buffer.data(), buffer.size());
+		if(received <= 0 || !transceiver.send(buffer.data(), received)) return;
+	}
+}
+
+// Serves a single connection, then lets the accept loop finish.
+struct echo_once_handler {
+	std::atomic_bool *served;
+
+	bool transceive(std::atomic_bool const &, net::tcp_transceiver<net::sockaddr_type_in, false> const &transceiver) {
+		int const one = 1;
+		::setsockopt(transceiver.native_handle(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		echo(transceiver);
+		served->store(true, std::memory_order_release);
+		return true;
+	}
+};
+
+template<typename transceiver_t>
+static void measure(char const *name, transceiver_t const &transceiver, size_t iterations, size_t total) {
+	uint8_t message[64]{};
+	std::vector<double> samples;
+	samples.reserve(iterations);
+	for(size_t i = 0; i < iterations; ++i) {
+		auto const begin = std::chrono::steady_clock::now();
+		if(!transceiver.send(message, sizeof(message)) || !transceiver.recv(message, sizeof(message))) {
+			::printf("%s: Connection lost.\n", name);
+			return;
+		}
+		samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+	}
+	std::sort(samples.begin(), samples.end());
+
+	std::vector<uint8_t> buffer(CHUNK_SIZE);
+	auto const begin = std::chrono::steady_clock::now();
+	std::thread sender([&]() {
+		std::vector<uint8_t> const chunk(CHUNK_SIZE, 0x5a);
+		for(size_t sent = 0; sent < total; sent += chunk.size()) {
+			if(!transceiver.send(chunk)) return;
+		}
+	});
+	size_t received = 0;
+	while(received < total) {
+		ssize_t const size = transceiver.recv_raw(buffer.data(), buffer.size());
+		if(size <= 0) break;
+		received += size;
+	}
+	double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	sender.join();
+
+	::printf("%-5s rtt p50 %7.2f us  p99 %7.2f us   echo %8.1f MiB/s\n", name, samples[samples.size() / 2], samples[samples.size() * 99 / 100],
+	         received / seconds / (1 << 20));
+}
+
+int main(int argc, char **argv) {
+	size_t const iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100'000;
+	size_t const total = (argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2048) << 20;
+
+	// Bound before the fork so the client cannot race the listeners.
+	net::shm_listener shm_server(CONTROL_PATH, 4 << 20);
+	std::atomic_bool served(false);
+	net::tcp_server<net::sockaddr_type_in, false, echo_once_handler> tcp_server(echo_once_handler{&served}, PORT, "127.0.0.1");
+
+	pid_t const child = ::fork();
+	if(child == 0) {
+		tcp_server.loop(served);
+		if(auto transceiver = shm_server.accept()) echo(*transceiver);
+		::_exit(0);
+	}
+
+	{
+		net::tcp_client<net::sockaddr_type_in, false> client(PORT, "127.0.0.1");
+		bool connected = false;
+		for(int attempt = 0; attempt < 100 && !(connected = client.connect()); ++attempt) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		if(connected) {
+			int const one = 1;
+			::setsockopt(client.native_handle(), IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+			measure("tcp", client, iterations, total);
+		}
+		else ::printf("tcp: Failed to connect.\n");
+	}
+	{
+		net::shm_client client(CONTROL_PATH);
+		if(client.connect()) measure("shm", client, iterations, total);
+		else ::printf("shm: Failed to connect.\n");
+	}
+	::waitpid(child, nullptr, 0);
+}
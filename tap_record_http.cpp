@@ -0,0 +1,235 @@
+#include "include/http/http_handler.hpp"
+#include "include/tap/traffic_tap.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records HTTP traffic with a traffic_tap attached to the listener, and serves the same application without
+// one as a target for tap_replay:
+//
+//   tap_record_http record <capture> [seconds = 2]    keep-alive overhead with and without the tap, then a
+//                                                     capture of mixed traffic (port 9982)
+//   tap_record_http serve [seconds = 30]              the same server untapped (port 9981)
+//   tap_replay <capture> 9981 127.0.0.1 [speed]
+
+namespace net = OFCT::networking;
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr in_port_t RECORD_PORT = 9982;
+constexpr in_port_t SERVE_PORT = 9981;
+constexpr size_t WORKERS = 8;
+
+struct app_service {
+	std::string large = std::string(32 * 1024, 'x');
+
+	void operator()(net::http_request const &request, net::http_response &response) {
+		if(request.path == "/small") response.set_body("Hello, World!");
+		else if(request.path == "/large") response.set_body(large);
+		else if(request.path == "/echo") response.set_body(request.body);
+		else if(request.path == "/slow") {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			response.set_body("done");
+		}
+		else response.set_status(404);
+	}
+};
+
+using server_t = net::tcp_server<net::sockaddr_type_in, false, net::http_handler<app_service>>;
+
+// Minimal blocking client that reads Content-Length framed responses.
+class client {
+public:
+	explicit client(in_port_t port) : fd(::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)) {
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(port);
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		ok = ::connect(fd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) == 0;
+		int const one = 1;
+		::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	}
+
+	~client() {
+		::close(fd);
+	}
+
+	[[nodiscard]] bool send(std::string_view request) {
+		while(ok && !request.empty()) {
+			ssize_t const sent = ::send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+			ok = sent > 0;
+			if(ok) request.remove_prefix(sent);
+		}
+		return ok;
+	}
+
+	[[nodiscard]] bool read_response() {
+		while(ok) {
+			size_t const head_end = pending.find("\r\n\r\n");
+			if(head_end != std::string::npos) {
+				size_t const length_at = pending.find("Content-Length: ");
+				size_t const length = length_at < head_end ? std::strtoul(pending.c_str() + length_at + 16, nullptr, 10) : 0;
+				if(pending.size() >= head_end + 4 + length) {
+					pending.erase(0, head_end + 4 + length);
+					return true;
+				}
+			}
+			char buffer[64 * 1024];
+			ssize_t const received = ::recv(fd, buffer, sizeof(buffer), 0);
+			ok = received > 0;
+			if(ok) pending.append(buffer, received);
+		}
+		return false;
+	}
+
+	void shut() { ::shutdown(fd, SHUT_WR); }
+
+	// After shut(): until the server has closed its end too.
+	void wait_closed() {
+		char buffer[4096];
+		while(::recv(fd, buffer, sizeof(buffer), 0) > 0) {}
+	}
+
+	[[nodiscard]] bool good() const { return ok; }
+
+private:
+	int fd;
+	bool ok;
+	std::string pending;
+};
+
+static std::string get(std::string_view path, bool close = false) {
+	return "GET " + std::string(path) + " HTTP/1.1\r\nHost: localhost\r\n" + (close ? "Connection: close\r\n" : "") + "\r\n";
+}
+
+// Keep-alive requests on one connection; returns requests per second.
+static double keep_alive_rate(size_t requests) {
+	client c(RECORD_PORT);
+	std::string const request = get("/small");
+	auto const begin = clock_type::now();
+	for(size_t i = 0; i < requests; ++i) {
+		if(!c.send(request) || !c.read_response()) return 0;
+	}
+	double const rate = requests / std::chrono::duration<double>(clock_type::now() - begin).count();
+	// The server's transceiver records its close into the tap, which must still exist then.
+	c.shut();
+	c.wait_closed();
+	return rate;
+}
+
+// Sessions of varied length, request mix, pipelining and think time, from a few concurrent users.
+static size_t mixed_traffic(double seconds) {
+	std::atomic_size_t total = 0;
+	std::vector<std::thread> users;
+	for(unsigned u = 0; u < 4; ++u) {
+		users.emplace_back([&, u]() {
+			std::mt19937 random(u + 1);
+			std::exponential_distribution<double> think(1000.0 / 2);
+			auto const end = clock_type::now() + std::chrono::duration<double>(seconds);
+			while(clock_type::now() < end) {
+				client c(RECORD_PORT);
+				size_t const session = 1 + random() % 30;
+				bool const server_closes = random() % 2;
+				for(size_t i = 0; i < session && c.good(); ++i) {
+					bool const last = i + 1 == session;
+					unsigned const kind = random() % 10;
+					if(kind < 5) (void) c.send(get("/small", last && server_closes));
+					else if(kind < 7) (void) c.send(get("/large", last && server_closes));
+					else if(kind < 8) (void) c.send(get("/slow", last && server_closes));
+					else if(kind < 9) {
+						std::string const body(1024 + random() % 3072, 'b');
+						(void) c.send("POST /echo HTTP/1.1\r\nHost: localhost\r\nContent-Length: " + std::to_string(body.size()) + "\r\n"
+						              + (last && server_closes ? "Connection: close\r\n" : "") + "\r\n" + body);
+					}
+					else {
+						// A pipelined burst.
+						(void) c.send(get("/small") + get("/small") + get("/large") + get("/small", last && server_closes));
+						for(int r = 0; r < 3; ++r) (void) c.read_response();
+						total.fetch_add(3, std::memory_order_relaxed);
+					}
+					if(c.read_response()) total.fetch_add(1, std::memory_order_relaxed);
+					std::this_thread::sleep_for(std::chrono::duration<double>(think(random)));
+				}
+				if(!server_closes) c.shut();
+			}
+		});
+	}
+	for(std::thread &user : users) user.join();
+	return total.load();
+}
+
+static void run(in_port_t port, std::atomic_bool &flag_quit, std::thread &thread, net::admission_control &admission,
+                std::unique_ptr<server_t> &server) {
+	server = std::make_unique<server_t>(net::http_handler<app_service>(app_service{}), port, "127.0.0.1");
+	thread = std::thread([&]() { server->loop(flag_quit, admission); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+static void stop(in_port_t port, std::atomic_bool &flag_quit, std::thread &thread) {
+	flag_quit.store(true, std::memory_order_release);
+	{
+		client waker(port);
+	}
+	thread.join();
+}
+
+int main(int argc, char **argv) {
+	std::string const mode = argc > 1 ? argv[1] : "";
+	net::admission_limits limits;
+	limits.target_delay = std::chrono::microseconds(0);
+	limits.workers = WORKERS;
+	net::admission_control admission(limits);
+	std::atomic_bool flag_quit(false);
+	std::thread thread;
+	std::unique_ptr<server_t> server;
+
+	if(mode == "serve") {
+		double const seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 30;
+		run(SERVE_PORT, flag_quit, thread, admission, server);
+		::printf("serving on %hu for %g s\n", SERVE_PORT, seconds);
+		std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+		stop(SERVE_PORT, flag_quit, thread);
+		return 0;
+	}
+	if(mode != "record" || argc < 3) {
+		::fprintf(stderr, "usage: %s record <capture> [seconds = 2] | %s serve [seconds = 30]\n", argv[0], argv[0]);
+		return 2;
+	}
+	double const seconds = argc > 3 ? std::strtod(argv[3], nullptr) : 2;
+
+	run(RECORD_PORT, flag_quit, thread, admission, server);
+
+	// Measured against a throwaway capture so the real one holds only the mixed traffic.
+	constexpr size_t OVERHEAD_REQUESTS = 100000;
+	double const untapped = keep_alive_rate(OVERHEAD_REQUESTS);
+	double tapped = 0;
+	{
+		net::tap_options options;
+		options.path = std::string(argv[2]) + ".overhead";
+		net::traffic_tap overhead_tap(options);
+		server->set_tap(&overhead_tap);
+		tapped = keep_alive_rate(OVERHEAD_REQUESTS);
+		server->set_tap(nullptr);
+		::unlink(options.path.c_str());
+	}
+	::printf("keep-alive /small: %.0f req/s untapped, %.0f req/s recorded (%.0f ns per request)\n", untapped, tapped, 1e9 / tapped - 1e9 / untapped);
+
+	net::tap_options options;
+	options.path = argv[2];
+	net::traffic_tap tap(options);
+	server->set_tap(&tap);
+	auto const begin = clock_type::now();
+	size_t const answered = mixed_traffic(seconds);
+	::printf("mixed traffic: %zu requests in %.2f s\n", answered, std::chrono::duration<double>(clock_type::now() - begin).count());
+
+	stop(RECORD_PORT, flag_quit, thread);
+	::printf("capture %s: %lu connections, %lu bytes, %lu records overwritten\n", argv[2], tap.connection_count(), tap.bytes_written(),
+	         tap.overwritten_count());
+}
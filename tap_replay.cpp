@@ -0,0 +1,305 @@
+#include "include/tap/tap_reader.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+// Replays a traffic_tap capture against a server: every recorded connection is reopened at its recorded
+// time, the bytes the server received are sent again on the recorded schedule, and responses are read and
+// counted against the recorded ones. Speed scales the schedule (2 replays twice as fast). Latency is
+// compared per request: recorded is the server's time from the last byte of a request to the last byte of
+// its response, replayed the client's over loopback or the network.
+//
+//   tap_replay <capture> <port> [ip = 127.0.0.1] [speed = 1]
+
+namespace net = OFCT::networking;
+
+using clock_type = std::chrono::steady_clock;
+
+// Recv records up to the server's next reply; expected is how many bytes that reply had.
+struct step {
+	struct chunk {
+		uint64_t at_ns;
+		std::span<uint8_t const> data;
+	};
+	std::vector<chunk> chunks;
+	size_t expected = 0;
+	uint64_t recorded_latency_ns = 0;
+};
+
+struct script {
+	uint64_t open_ns = 0;
+	std::vector<step> steps;
+	bool client_closed = false;
+	size_t sent_bytes = 0;
+	size_t expected_bytes = 0;
+};
+
+static std::map<uint32_t, script> load(net::tap_reader const &reader, size_t &partial) {
+	std::map<uint32_t, script> scripts;
+	std::map<uint32_t, uint64_t> last_recv;
+	bool const consistent = reader.for_each([&](net::tap_record const &record) {
+		auto it = scripts.find(record.connection);
+		if(record.event == net::tap_open) {
+			scripts[record.connection].open_ns = record.timestamp_ns;
+			return;
+		}
+		// Connections whose start was overwritten in the ring cannot be replayed faithfully.
+		if(it == scripts.end()) return;
+		script &s = it->second;
+		switch(record.event) {
+		case net::tap_recv:
+			if(s.steps.empty() || s.steps.back().expected) s.steps.emplace_back();
+			s.steps.back().chunks.push_back(step::chunk{record.timestamp_ns, record.data});
+			s.sent_bytes += record.data.size();
+			last_recv[record.connection] = record.timestamp_ns;
+			break;
+		case net::tap_send:
+			// Bytes the server sent before the client said anything (a banner) belong to an empty first step.
+			if(s.steps.empty()) s.steps.emplace_back();
+			s.steps.back().expected += record.data.size();
+			s.steps.back().recorded_latency_ns = record.timestamp_ns - (s.steps.back().chunks.empty() ? s.open_ns : last_recv[record.connection]);
+			s.expected_bytes += record.data.size();
+			break;
+		case net::tap_peer_close:
+			s.client_closed = true;
+			break;
+		default:
+			break;
+		}
+	});
+	if(!consistent) ::fprintf(stderr, "capture is inconsistent past some point; replaying what precedes it\n");
+	partial = reader.connection_count() - scripts.size();
+	return scripts;
+}
+
+struct live_connection {
+	script const *s;
+	int fd = -1;
+	size_t step = 0;
+	size_t chunk = 0;
+	size_t chunk_offset = 0;
+	// Steps whose requests are fully sent and whose responses are still due, with the time of their last byte.
+	std::vector<std::pair<size_t, clock_type::time_point>> awaiting;
+	size_t answered = 0;
+	size_t received = 0;
+	size_t expected_so_far = 0;
+	clock_type::time_point last_send;
+	bool write_shut = false;
+	bool want_write = false;
+};
+
+static double percentile(std::vector<double> &values, double p) {
+	if(values.empty()) return 0;
+	std::sort(values.begin(), values.end());
+	return values[std::min(values.size() - 1, static_cast<size_t>(values.size() * p))];
+}
+
+int main(int argc, char **argv) {
+	if(argc < 3) {
+		::fprintf(stderr, "usage: %s <capture> <port> [ip = 127.0.0.1] [speed = 1]\n", argv[0]);
+		return 2;
+	}
+	net::tap_reader const reader(argv[1]);
+	in_port_t const port = static_cast<in_port_t>(std::strtoul(argv[2], nullptr, 10));
+	char const *const ip = argc > 3 ? argv[3] : "127.0.0.1";
+	double const speed = argc > 4 ? std::strtod(argv[4], nullptr) : 1;
+	if(speed <= 0) {
+		::fprintf(stderr, "speed must be positive\n");
+		return 2;
+	}
+
+	size_t partial = 0;
+	std::map<uint32_t, script> const scripts = load(reader, partial);
+	std::vector<script const*> order;
+	uint64_t first_ns = UINT64_MAX;
+	uint64_t last_ns = 0;
+	size_t requests = 0;
+	size_t recorded_up = 0;
+	size_t recorded_down = 0;
+	std::vector<double> recorded_latencies;
+	for(auto const &[id, s] : scripts) {
+		order.push_back(&s);
+		first_ns = std::min(first_ns, s.open_ns);
+		for(step const &st : s.steps) {
+			if(!st.chunks.empty()) last_ns = std::max(last_ns, st.chunks.back().at_ns);
+			if(!st.chunks.empty() && st.expected) {
+				++requests;
+				recorded_latencies.push_back(st.recorded_latency_ns / 1e6);
+			}
+		}
+		recorded_up += s.sent_bytes;
+		recorded_down += s.expected_bytes;
+	}
+	std::sort(order.begin(), order.end(), [](script const *a, script const *b) { return a->open_ns < b->open_ns; });
+	if(order.empty()) {
+		::fprintf(stderr, "nothing to replay\n");
+		return 1;
+	}
+	double const recorded_seconds = (last_ns - first_ns) / 1e9;
+	::printf("capture: %zu connections (%zu not replayable, %lu records overwritten), %zu requests, %zu bytes up, %zu down over %.3f s\n",
+	         order.size(), partial, reader.overwritten_count(), requests, recorded_up, recorded_down, recorded_seconds);
+
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = inet_addr(ip);
+
+	int const epfd = ::epoll_create1(EPOLL_CLOEXEC);
+	std::map<int, live_connection> live;
+	std::vector<double> latencies;
+	size_t next = 0;
+	size_t sent_total = 0;
+	size_t received_total = 0;
+	size_t mismatched = 0;
+	size_t failed = 0;
+	auto const begin = clock_type::now();
+	// The schedule in capture time that has come due.
+	auto due = [&](uint64_t at_ns) {
+		return clock_type::now() - begin >= std::chrono::nanoseconds(static_cast<int64_t>((at_ns - first_ns) / speed));
+	};
+
+	auto finish = [&](int fd) {
+		live_connection &c = live.at(fd);
+		if(c.received != c.s->expected_bytes) ++mismatched;
+		received_total += c.received;
+		::close(fd);
+		live.erase(fd);
+	};
+
+	// Everything sent and every response byte back; a server that closes first is noticed by recv instead.
+	auto is_done = [](live_connection const &c) {
+		return !c.want_write && c.step == c.s->steps.size() && c.received >= c.s->expected_bytes;
+	};
+
+	// Sends whatever of the script has come due; false if the connection broke.
+	auto pump = [&](live_connection &c) {
+		while(c.step < c.s->steps.size()) {
+			step const &st = c.s->steps[c.step];
+			if(c.chunk == st.chunks.size()) {
+				c.expected_so_far += st.expected;
+				// A banner answers no request; like the recorded side, only requests get a latency.
+				if(st.expected && !st.chunks.empty()) c.awaiting.emplace_back(c.expected_so_far, c.last_send);
+				++c.step;
+				c.chunk = 0;
+				continue;
+			}
+			step::chunk const &ch = st.chunks[c.chunk];
+			if(!due(ch.at_ns)) return true;
+			// Taken before the call: on loopback the server may well have answered by the time send returns.
+			c.last_send = clock_type::now();
+			ssize_t const sent = ::send(c.fd, ch.data.data() + c.chunk_offset, ch.data.size() - c.chunk_offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+			if(sent < 0) {
+				if(errno != EAGAIN && errno != EWOULDBLOCK) return false;
+				if(!c.want_write) {
+					epoll_event event{EPOLLIN | EPOLLOUT, {.fd = c.fd}};
+					::epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &event);
+					c.want_write = true;
+				}
+				return true;
+			}
+			sent_total += sent;
+			c.chunk_offset += sent;
+			if(c.chunk_offset == ch.data.size()) {
+				c.chunk_offset = 0;
+				++c.chunk;
+			}
+		}
+		if(c.want_write) {
+			epoll_event event{EPOLLIN, {.fd = c.fd}};
+			::epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &event);
+			c.want_write = false;
+		}
+		if(c.s->client_closed && !c.write_shut) {
+			::shutdown(c.fd, SHUT_WR);
+			c.write_shut = true;
+		}
+		return true;
+	};
+
+	epoll_event events[256];
+	static uint8_t sink[256 * 1024];
+	auto const deadline = begin + std::chrono::duration<double>(recorded_seconds / speed + 30);
+	while((next < order.size() || !live.empty()) && clock_type::now() < deadline) {
+		for(; next < order.size() && due(order[next]->open_ns); ++next) {
+			int const fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+			if(::connect(fd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) && errno != EINPROGRESS) {
+				::close(fd);
+				++failed;
+				continue;
+			}
+			int const one = 1;
+			::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+			live_connection &c = live[fd];
+			c.s = order[next];
+			c.fd = fd;
+			// Writable once connected.
+			epoll_event event{EPOLLIN | EPOLLOUT, {.fd = fd}};
+			::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event);
+			c.want_write = true;
+		}
+
+		std::vector<int> broken;
+		std::vector<int> done;
+		for(auto &[fd, c] : live) {
+			if(!c.want_write && !pump(c)) broken.push_back(fd);
+			else if(is_done(c)) done.push_back(fd);
+		}
+		for(int fd : broken) {
+			++failed;
+			finish(fd);
+		}
+		for(int fd : done) finish(fd);
+
+		int const ready = ::epoll_wait(epfd, events, 256, 1);
+		for(int i = 0; i < ready; ++i) {
+			int const fd = events[i].data.fd;
+			auto it = live.find(fd);
+			if(it == live.end()) continue;
+			live_connection &c = it->second;
+			if(events[i].events & (EPOLLOUT | EPOLLERR)) {
+				c.want_write = false;
+				if(!pump(c)) {
+					++failed;
+					finish(fd);
+					continue;
+				}
+			}
+			if(!(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) continue;
+			ssize_t const received = ::recv(fd, sink, sizeof(sink), 0);
+			if(received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+			if(received <= 0) {
+				finish(fd);
+				continue;
+			}
+			c.received += received;
+			auto const now = clock_type::now();
+			while(c.answered < c.awaiting.size() && c.received >= c.awaiting[c.answered].first) {
+				latencies.push_back(std::chrono::duration<double, std::milli>(now - c.awaiting[c.answered].second).count());
+				++c.answered;
+			}
+			if(is_done(c)) finish(fd);
+		}
+	}
+	size_t const stalled = live.size();
+	for(auto &[fd, c] : live) ::close(fd);
+	::close(epfd);
+	double const seconds = std::chrono::duration<double>(clock_type::now() - begin).count();
+
+	::printf("replay at %gx: %.3f s, %zu bytes up (%zu recorded), %zu down (%zu recorded)\n", speed, seconds, sent_total, recorded_up, received_total,
+	         recorded_down);
+	::printf("connections: %zu failed, %zu stalled, %zu with a different response volume\n", failed, stalled, mismatched);
+	::printf("%-9s %8s %10s %10s %10s\n", "latency", "requests", "p50 ms", "p99 ms", "p99.9 ms");
+	size_t const recorded_count = recorded_latencies.size();
+	size_t const replayed_count = latencies.size();
+	::printf("%-9s %8zu %10.3f %10.3f %10.3f\n", "recorded", recorded_count, percentile(recorded_latencies, 0.5), percentile(recorded_latencies, 0.99),
+	         percentile(recorded_latencies, 0.999));
+	::printf("%-9s %8zu %10.3f %10.3f %10.3f\n", "replayed", replayed_count, percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 0.999));
+	return failed || stalled ? 1 : 0;
+}